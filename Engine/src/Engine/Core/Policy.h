@@ -14,4 +14,10 @@ namespace eng
     Ascending,
     Descending
   };
+
+  enum class IndexPolicy
+  {
+    PerCommand,
+    SharedQuads
+  };
 }
\ No newline at end of file
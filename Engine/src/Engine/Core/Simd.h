@@ -0,0 +1,25 @@
+#pragma once
+
+/*
+  Instruction set detection for hand-vectorized code paths, derived from the compiler's target feature macros.
+  GCC and Clang define a macro for each enabled instruction set. MSVC only defines __AVX__ and __AVX2__ for
+  /arch:AVX and /arch:AVX2, and targets SSE2 on x64 or with /arch:SSE2 on x86. It has no dedicated macro for SSSE3,
+  which is implied by AVX. Each level implies the ones below it, so the intrinsics header is included whenever
+  any of them is available. Code using these macros should always provide a scalar fallback.
+*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define ENG_SIMD_SSE2
+#endif
+#if defined(ENG_SIMD_SSE2) && (defined(__SSSE3__) || defined(__AVX__))
+  #define ENG_SIMD_SSSE3
+#endif
+#if defined(ENG_SIMD_SSSE3) && defined(__AVX__)
+  #define ENG_SIMD_AVX
+#endif
+#if defined(ENG_SIMD_AVX) && defined(__AVX2__)
+  #define ENG_SIMD_AVX2
+#endif
+
+#if defined(ENG_SIMD_SSE2)
+  #include <immintrin.h>
+#endif
\ No newline at end of file
@@ -1,11 +1,240 @@
 #include "ENpch.h"
 #include "Noise.h"
+#include "Basics.h"
 #include "Engine/Core/Algorithm.h"
+#include "Engine/Core/Casting.h"
+#include "Engine/Core/Simd.h"
 
 #include <glm/gtc/noise.hpp>
 
 namespace eng::math
 {
+  static_assert(std::is_same_v<length_t, f32>, "Batch noise evaluation assumes single-precision lengths!");
+
+#if defined(ENG_SIMD_SSE2)
+  /*
+    Thin wrappers around SIMD intrinsics, so that the simplex noise kernel can be written once for every vector width.
+  */
+  struct SseLanes
+  {
+    using Vector = __m128;
+    static constexpr i32 Width = 4;
+
+    static Vector load(const f32* address) { return _mm_loadu_ps(address); }
+    static void store(f32* address, Vector a) { _mm_storeu_ps(address, a); }
+    static Vector broadcast(f32 value) { return _mm_set1_ps(value); }
+
+    static Vector add(Vector a, Vector b) { return _mm_add_ps(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm_sub_ps(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm_mul_ps(a, b); }
+    static Vector div(Vector a, Vector b) { return _mm_div_ps(a, b); }
+    static Vector max(Vector a, Vector b) { return _mm_max_ps(a, b); }
+    static Vector abs(Vector a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    static Vector greaterThan(Vector a, Vector b) { return _mm_cmpgt_ps(a, b); }
+    static Vector select(Vector mask, Vector a, Vector b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+    // SSE2 has no rounding instructions. Truncation is exact for the magnitudes seen here, and is corrected for negative values.
+    static Vector floor(Vector a)
+    {
+      Vector truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+      return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a), _mm_set1_ps(1.0f)));
+    }
+  };
+#endif
+
+#if defined(ENG_SIMD_AVX)
+  struct AvxLanes
+  {
+    using Vector = __m256;
+    static constexpr i32 Width = 8;
+
+    static Vector load(const f32* address) { return _mm256_loadu_ps(address); }
+    static void store(f32* address, Vector a) { _mm256_storeu_ps(address, a); }
+    static Vector broadcast(f32 value) { return _mm256_set1_ps(value); }
+
+    static Vector add(Vector a, Vector b) { return _mm256_add_ps(a, b); }
+    static Vector sub(Vector a, Vector b) { return _mm256_sub_ps(a, b); }
+    static Vector mul(Vector a, Vector b) { return _mm256_mul_ps(a, b); }
+    static Vector div(Vector a, Vector b) { return _mm256_div_ps(a, b); }
+    static Vector max(Vector a, Vector b) { return _mm256_max_ps(a, b); }
+    static Vector abs(Vector a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    static Vector greaterThan(Vector a, Vector b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static Vector select(Vector mask, Vector a, Vector b) { return _mm256_blendv_ps(b, a, mask); }
+    static Vector floor(Vector a) { return _mm256_floor_ps(a); }
+  };
+#endif
+
+  /*
+    2D simplex noise, following the same sequence of operations as glm::simplex so that results agree with it.
+  */
+  template<typename L>
+  static typename L::Vector simplex(typename L::Vector vx, typename L::Vector vy)
+  {
+    using Vector = typename L::Vector;
+
+    const Vector cx = L::broadcast(0.211324865405187f);   // (3 - sqrt(3)) / 6
+    const Vector cy = L::broadcast(0.366025403784439f);   // (sqrt(3) - 1) / 2
+    const Vector cz = L::broadcast(-0.577350269189626f);  // -1 + 2 * cx
+    const Vector cw = L::broadcast(0.024390243902439f);   // 1 / 41
+    const Vector zero = L::broadcast(0.0f);
+    const Vector half = L::broadcast(0.5f);
+    const Vector one = L::broadcast(1.0f);
+    const Vector two = L::broadcast(2.0f);
+
+    auto mod289 = [](Vector x)
+    {
+      return L::sub(x, L::mul(L::floor(L::mul(x, L::broadcast(1.0f / 289.0f))), L::broadcast(289.0f)));
+    };
+    auto permute = [&mod289, &one](Vector x)
+    {
+      return mod289(L::mul(L::add(L::mul(x, L::broadcast(34.0f)), one), x));
+    };
+
+    // First corner
+    Vector skew = L::add(L::mul(vx, cy), L::mul(vy, cy));
+    Vector ix = L::floor(L::add(vx, skew));
+    Vector iy = L::floor(L::add(vy, skew));
+    Vector unskew = L::add(L::mul(ix, cx), L::mul(iy, cx));
+    Vector x0x = L::add(L::sub(vx, ix), unskew);
+    Vector x0y = L::add(L::sub(vy, iy), unskew);
+
+    // Other corners
+    Vector i1x = L::select(L::greaterThan(x0x, x0y), one, zero);
+    Vector i1y = L::sub(one, i1x);
+    Vector x1x = L::sub(L::add(x0x, cx), i1x);
+    Vector x1y = L::sub(L::add(x0y, cx), i1y);
+    Vector x2x = L::add(x0x, cz);
+    Vector x2y = L::add(x0y, cz);
+
+    // Permutations
+    Vector modulus = L::broadcast(289.0f);
+    ix = L::sub(ix, L::mul(modulus, L::floor(L::div(ix, modulus))));
+    iy = L::sub(iy, L::mul(modulus, L::floor(L::div(iy, modulus))));
+
+    // Contribution of a single corner, with gradients taken from 41 points on a line mapped onto a diamond
+    auto cornerContribution = [&](Vector offsetX, Vector offsetY, Vector cornerX, Vector cornerY)
+    {
+      Vector p = permute(L::add(L::add(permute(L::add(iy, offsetY)), ix), offsetX));
+
+      Vector m = L::max(L::sub(half, L::add(L::mul(cornerX, cornerX), L::mul(cornerY, cornerY))), zero);
+      m = L::mul(m, m);
+      m = L::mul(m, m);
+
+      Vector pw = L::mul(p, cw);
+      Vector x = L::sub(L::mul(two, L::sub(pw, L::floor(pw))), one);
+      Vector h = L::sub(L::abs(x), half);
+      Vector ox = L::floor(L::add(x, half));
+      Vector a0 = L::sub(x, ox);
+
+      m = L::mul(m, L::sub(L::broadcast(1.79284291400159f), L::mul(L::broadcast(0.85373472095314f), L::add(L::mul(a0, a0), L::mul(h, h)))));
+      return L::mul(m, L::add(L::mul(a0, cornerX), L::mul(h, cornerY)));
+    };
+
+    Vector n0 = cornerContribution(zero, zero, x0x, x0y);
+    Vector n1 = cornerContribution(i1x, i1y, x1x, x1y);
+    Vector n2 = cornerContribution(one, one, x2x, x2y);
+    return L::mul(L::broadcast(130.0f), L::add(L::add(n0, n1), n2));
+  }
+
+  /*
+    Evaluates octave noise for as many whole groups of lanes as fit in the given points.
+    \returns The number of points that were evaluated.
+  */
+  template<typename L>
+  static uSize batchOctaveNoise(std::span<const Vec2> points, std::span<length_t> results, i32 octaveCount, length_t firstAmplitude, f32 amplitudeDecay, length_t firstScale, f32 scaleDecay)
+  {
+    uSize pointIndex = 0;
+    for (; pointIndex + L::Width <= points.size(); pointIndex += L::Width)
+    {
+      std::array<f32, L::Width> pointsX;
+      std::array<f32, L::Width> pointsY;
+      for (i32 lane = 0; lane < L::Width; ++lane)
+      {
+        pointsX[lane] = points[pointIndex + lane].x;
+        pointsY[lane] = points[pointIndex + lane].y;
+      }
+      typename L::Vector x = L::load(pointsX.data());
+      typename L::Vector y = L::load(pointsY.data());
+
+      typename L::Vector noiseValues = L::broadcast(0.0f);
+      length_t amplitude = firstAmplitude;
+      length_t scale = firstScale;
+      for (i32 i = 0; i < octaveCount; ++i)
+      {
+        typename L::Vector scaleVector = L::broadcast(scale);
+        noiseValues = L::add(noiseValues, L::mul(L::broadcast(amplitude), simplex<L>(L::div(x, scaleVector), L::div(y, scaleVector))));
+        amplitude *= amplitudeDecay;
+        scale *= scaleDecay;
+      }
+      L::store(&results[pointIndex], noiseValues);
+    }
+    return pointIndex;
+  }
+
+  static length_t normalizationFactor(i32 octaveCount, f32 amplitudeDecay)
+  {
+    length_t normalizedAmplitude = 1_m;
+    length_t amplitudeSum = 0_m;
+    for (i32 i = 0; i < octaveCount; ++i)
+    {
+      amplitudeSum += normalizedAmplitude;
+      normalizedAmplitude *= amplitudeDecay;
+    }
+    return amplitudeSum;
+  }
+
+  /*
+    Octaves whose scale spans at least this many lattice spacings are interpolated from a coarse lattice. The Catmull-Rom
+    interpolation error of a single octave is at most about 21 (h / s)^3 times its amplitude, where h is the lattice
+    spacing and s is the octave scale, so this keeps each interpolated octave within 0.5% of its amplitude.
+  */
+  static constexpr i32 c_LatticeSpacingsPerScale = 16;
+
+  // An octave is only worth interpolating if the lattice is coarser than the grid
+  static constexpr i32 c_MinLatticeStride = 2;
+
+  struct Octave
+  {
+    length_t amplitude;
+    length_t scale;
+  };
+
+  /*
+    \returns The Catmull-Rom weights of the four lattice values surrounding a point that is a fraction t of the way between the middle two.
+  */
+  static std::array<length_t, 4> cubicWeights(length_t t)
+  {
+    length_t t2 = square(t);
+    length_t t3 = cube(t);
+    return { 0.5_m * (-t3 + 2 * t2 - t),
+             0.5_m * (3 * t3 - 5 * t2 + 2),
+             0.5_m * (-3 * t3 + 4 * t2 + t),
+             0.5_m * (t3 - t2) };
+  }
+
+  static std::vector<Vec2> gridPoints(const Vec2& origin, length_t spacing, i32 gridSize)
+  {
+    std::vector<Vec2> points(square(gridSize));
+    for (i32 i = 0; i < gridSize; ++i)
+      for (i32 j = 0; j < gridSize; ++j)
+        points[gridSize * i + j] = origin + spacing * Vec2(i, j);
+    return points;
+  }
+
+  /*
+    Adds the given octaves of noise at each point to the corresponding entry of results.
+  */
+  static void accumulateOctaves(std::span<const Vec2> points, std::span<const Octave> octaves, std::span<length_t> results)
+  {
+    std::vector<length_t> octaveValues(points.size());
+    for (const Octave& octave : octaves)
+    {
+      octaveNoise(points, octaveValues, 1, octave.amplitude, 1.0f, octave.scale, 1.0f);
+      for (uSize pointIndex = 0; pointIndex < points.size(); ++pointIndex)
+        results[pointIndex] += octaveValues[pointIndex];
+    }
+  }
+
   length_t octaveNoise(const Vec2& pointXY, i32 octaveCount, length_t firstAmplitude, f32 amplitudeDecay, length_t firstScale, f32 scaleDecay)
   {
     length_t noiseValue = 0_m;
@@ -20,14 +249,90 @@ namespace eng::math
 
   length_t normalizedOctaveNoise(const Vec2& pointXY, i32 octaveCount, f32 amplitudeDecay, length_t firstScale, f32 scaleDecay)
   {
-    length_t normalizedAmplitude = 1_m;
-    length_t normalizationFactor = 0_m;
+    return octaveNoise(pointXY, octaveCount, 1_m / normalizationFactor(octaveCount, amplitudeDecay), amplitudeDecay, firstScale, scaleDecay);
+  }
+
+  void octaveNoise(std::span<const Vec2> points, std::span<length_t> results, i32 octaveCount, length_t firstAmplitude, f32 amplitudeDecay, length_t firstScale, f32 scaleDecay)
+  {
+    ENG_CORE_ASSERT(results.size() >= points.size(), "Not enough space for results!");
+
+    uSize firstScalarPoint = 0;
+#if defined(ENG_SIMD_AVX)
+    firstScalarPoint = batchOctaveNoise<AvxLanes>(points, results, octaveCount, firstAmplitude, amplitudeDecay, firstScale, scaleDecay);
+#elif defined(ENG_SIMD_SSE2)
+    firstScalarPoint = batchOctaveNoise<SseLanes>(points, results, octaveCount, firstAmplitude, amplitudeDecay, firstScale, scaleDecay);
+#endif
+
+    for (uSize pointIndex = firstScalarPoint; pointIndex < points.size(); ++pointIndex)
+      results[pointIndex] = octaveNoise(points[pointIndex], octaveCount, firstAmplitude, amplitudeDecay, firstScale, scaleDecay);
+  }
+
+  void normalizedOctaveNoise(std::span<const Vec2> points, std::span<length_t> results, i32 octaveCount, f32 amplitudeDecay, length_t firstScale, f32 scaleDecay)
+  {
+    octaveNoise(points, results, octaveCount, 1_m / normalizationFactor(octaveCount, amplitudeDecay), amplitudeDecay, firstScale, scaleDecay);
+  }
+
+  void octaveNoiseGrid(const Vec2& origin, length_t spacing, i32 gridSize, std::span<length_t> results, i32 octaveCount, length_t firstAmplitude, f32 amplitudeDecay, length_t firstScale, f32 scaleDecay)
+  {
+    ENG_PROFILE_FUNCTION();
+    ENG_CORE_ASSERT(gridSize > 0 && spacing > 0_m, "Invalid noise grid!");
+    ENG_CORE_ASSERT(results.size() >= eng::arithmeticCast<uSize>(square(gridSize)), "Not enough space for results!");
+
+    // Octaves that are smooth over several grid spacings share a lattice that is fine enough for the smallest of them
+    i32 latticeStride = std::max(gridSize - 1, c_MinLatticeStride);
+    std::vector<Octave> latticeOctaves;
+    std::vector<Octave> denseOctaves;
     for (i32 i = 0; i < octaveCount; ++i)
     {
-      normalizationFactor += normalizedAmplitude;
-      normalizedAmplitude *= amplitudeDecay;
+      length_t maxStride = std::min(firstScale / (c_LatticeSpacingsPerScale * spacing), eng::arithmeticUpcast<length_t>(gridSize));
+      if (maxStride >= c_MinLatticeStride)
+      {
+        latticeOctaves.push_back({ firstAmplitude, firstScale });
+        latticeStride = std::min(latticeStride, eng::arithmeticCastUnchecked<i32>(maxStride));
+      }
+      else
+        denseOctaves.push_back({ firstAmplitude, firstScale });
+
+      firstAmplitude *= amplitudeDecay;
+      firstScale *= scaleDecay;
+    }
+
+    std::fill_n(results.begin(), square(gridSize), 0_m);
+    if (!denseOctaves.empty())
+      accumulateOctaves(gridPoints(origin, spacing, gridSize), denseOctaves, results);
+    if (latticeOctaves.empty())
+      return;
+
+    // The lattice extends one node beyond the grid on each side, so that every grid point has four nodes around it along each axis
+    i32 cellCount = std::max((gridSize - 2) / latticeStride + 1, 1);
+    i32 latticeSize = cellCount + 3;
+    length_t latticeSpacing = latticeStride * spacing;
+    std::vector<length_t> latticeValues(square(latticeSize), 0_m);
+    accumulateOctaves(gridPoints(origin - latticeSpacing, latticeSpacing, latticeSize), latticeOctaves, latticeValues);
+
+    std::vector<i32> cells(gridSize);
+    std::vector<std::array<length_t, 4>> weights(gridSize);
+    for (i32 i = 0; i < gridSize; ++i)
+    {
+      cells[i] = std::min(i / latticeStride, cellCount - 1);
+      weights[i] = cubicWeights(eng::arithmeticUpcast<length_t>(i - latticeStride * cells[i]) / latticeStride);
     }
 
-    return octaveNoise(pointXY, octaveCount, 1_m / normalizationFactor, amplitudeDecay, firstScale, scaleDecay);
+    // Bicubic interpolation is separable, so interpolate along the first axis and then along the second
+    std::vector<length_t> partialValues(gridSize * latticeSize, 0_m);
+    for (i32 i = 0; i < gridSize; ++i)
+      for (i32 node = 0; node < 4; ++node)
+        for (i32 b = 0; b < latticeSize; ++b)
+          partialValues[latticeSize * i + b] += weights[i][node] * latticeValues[latticeSize * (cells[i] + node) + b];
+
+    for (i32 i = 0; i < gridSize; ++i)
+      for (i32 j = 0; j < gridSize; ++j)
+        for (i32 node = 0; node < 4; ++node)
+          results[gridSize * i + j] += weights[j][node] * partialValues[latticeSize * i + cells[j] + node];
+  }
+
+  void normalizedOctaveNoiseGrid(const Vec2& origin, length_t spacing, i32 gridSize, std::span<length_t> results, i32 octaveCount, f32 amplitudeDecay, length_t firstScale, f32 scaleDecay)
+  {
+    octaveNoiseGrid(origin, spacing, gridSize, results, octaveCount, 1_m / normalizationFactor(octaveCount, amplitudeDecay), amplitudeDecay, firstScale, scaleDecay);
   }
 }
\ No newline at end of file
@@ -15,4 +15,23 @@ namespace eng::math
     \returns A value whose absolute value is bounded by 1.
   */
   length_t normalizedOctaveNoise(const Vec2& pointXY, i32 octaveCount, f32 amplitudeDecay, length_t firstScale, f32 scaleDecay);
+
+  /*
+    Batch versions of the octave noise functions, which evaluate the noise at every given point and write it to the
+    corresponding entry of results. Points are processed in SIMD lanes if available, with a scalar fallback for the
+    remainder. Results match the single-point versions up to floating-point rounding.
+  */
+  void octaveNoise(std::span<const Vec2> points, std::span<length_t> results, i32 octaveCount, length_t firstAmplitude, f32 amplitudeDecay, length_t firstScale, f32 scaleDecay);
+  void normalizedOctaveNoise(std::span<const Vec2> points, std::span<length_t> results, i32 octaveCount, f32 amplitudeDecay, length_t firstScale, f32 scaleDecay);
+
+  /*
+    Grid versions of the octave noise functions, which evaluate the noise at the points origin + spacing * (i, j) for
+    0 <= i, j < gridSize and write the value at (i, j) to results[gridSize * i + j].
+
+    Octaves that vary slowly across the grid are sampled on a coarse lattice and bicubically interpolated, and only the
+    remaining high-frequency octaves are evaluated at every point. Each interpolated octave differs from its exact value
+    by at most 0.5% of its amplitude, and is exact at lattice nodes.
+  */
+  void octaveNoiseGrid(const Vec2& origin, length_t spacing, i32 gridSize, std::span<length_t> results, i32 octaveCount, length_t firstAmplitude, f32 amplitudeDecay, length_t firstScale, f32 scaleDecay);
+  void normalizedOctaveNoiseGrid(const Vec2& origin, length_t spacing, i32 gridSize, std::span<length_t> results, i32 octaveCount, f32 amplitudeDecay, length_t firstScale, f32 scaleDecay);
 }
\ No newline at end of file
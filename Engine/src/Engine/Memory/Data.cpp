@@ -9,6 +9,42 @@ namespace eng::mem
   uSize GenericData::elementCount() const { return m_ElementCount; }
   bool GenericData::empty() const { return size() == 0; }
 
+  /*
+    The 64-bit finalizer of MurmurHash3. Every input bit affects every output bit.
+  */
+  static constexpr u64 fmix64(u64 k)
+  {
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCD;
+    k ^= k >> 33;
+    k *= 0xC4CEB9FE1A85EC53;
+    k ^= k >> 33;
+    return k;
+  }
+
+  u64 GenericData::contentHash(u64 seed) const
+  {
+    static constexpr u64 c_FNVPrime = 0x100000001B3;
+
+    const std::byte* bytes = static_cast<const std::byte*>(m_Data);
+    uSize dataSize = size();
+
+    u64 hash = (seed ^ dataSize) * c_FNVPrime;
+    uSize offset = 0;
+    for (; offset + sizeof(u64) <= dataSize; offset += sizeof(u64))
+    {
+      u64 word;
+      std::memcpy(&word, bytes + offset, sizeof(u64));
+
+      // Multiplication only carries bits upwards, so words are mixed first. Otherwise, data that only differs in the
+      // high bits of its words (e.g. vertex lighting) would only differ in the high bits of the hash.
+      hash = (hash ^ fmix64(word)) * c_FNVPrime;
+    }
+    for (; offset < dataSize; ++offset)
+      hash = (hash ^ static_cast<u64>(bytes[offset])) * c_FNVPrime;
+    return fmix64(hash);
+  }
+
   GenericData::GenericData()
     : GenericData(nullptr, 0, 0) {}
   GenericData::GenericData(const void* data, uSize elementSize, uSize elementCount)
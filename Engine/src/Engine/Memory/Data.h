@@ -18,6 +18,12 @@ namespace eng::mem
     uSize elementCount() const;
     bool empty() const;
 
+    /*
+      \returns A 64-bit FNV-1a style hash of the data, processed in 8-byte words that are each passed through an
+                avalanching mix. Hashes can be chained by passing a previous hash as the seed.
+    */
+    u64 contentHash(u64 seed = 0xCBF29CE484222325) const;
+
   protected:
     GenericData();
     GenericData(const void* data, uSize elementSize, uSize elementCount);
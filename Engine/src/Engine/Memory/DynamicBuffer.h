@@ -18,6 +18,11 @@ namespace eng::mem
     virtual void bind() const = 0;
     virtual void unbind() const = 0;
 
+    /*
+      Binds the buffer to a shader storage binding point, so that its contents can be read directly in shaders.
+    */
+    virtual void bindAsStorage(u32 binding) const = 0;
+
     virtual Type type() const = 0;
     virtual uSize size() const = 0;
 
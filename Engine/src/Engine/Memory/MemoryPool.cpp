@@ -18,6 +18,7 @@ namespace eng::mem
 
   void MemoryPool::bind() const { m_Buffer->bind(); }
   void MemoryPool::unbind() const { m_Buffer->unbind(); }
+  void MemoryPool::bindAsStorage(u32 binding) const { m_Buffer->bindAsStorage(binding); }
   const std::shared_ptr<DynamicBuffer>& MemoryPool::buffer() { return m_Buffer; }
 
   bool MemoryPool::validAllocation(address_t address) const
@@ -46,6 +46,7 @@ namespace eng::mem
 
     void bind() const;
     void unbind() const;
+    void bindAsStorage(u32 binding) const;
 
     const std::shared_ptr<DynamicBuffer>& buffer();
 
@@ -31,6 +31,8 @@ namespace eng
     A CRTP class that represents a single multi-draw command.
     Derived classes must provided vertexData() and clearData() functions.
     Derived classes of the indexed variant must also provide indexData() function.
+    Derived classes of the non-indexed variant may provide a static VerticesPerElement() function
+    if each element of their vertex data is expanded into multiple vertices in the shader.
   */
   template<typename Derived, Hashable Identifier, bool IsIndexed>
   class GenericDrawCommand : private NonCopyable
@@ -40,6 +42,7 @@ namespace eng
     CommandData m_CommandData;
     Identifier m_ID;
     std::shared_ptr<uSize> m_CommandIndex;
+    std::optional<u64> m_ContentHash;
 
   public:
     using IDType = Identifier;
@@ -62,12 +65,24 @@ namespace eng
         return m_CommandData.firstVertex;
     }
 
+    /*
+      Sets the index count for commands drawn from a shared quad index buffer, in which case indexData() is never queried.
+      \returns The number of indices needed to draw the command's vertices as quads.
+    */
+    u32 quadIndexCount()
+    {
+      static_assert(IsIndexed, "Non-indexed commands cannot use shared quad indices!");
+      u32 quadVertexCount = vertexCount();
+      ENG_CORE_ASSERT(quadVertexCount % 4 == 0, "Vertex count must be a multiple of four to be drawn as quads!");
+      return m_CommandData.indexCount = 6 * (quadVertexCount / 4);
+    }
+
     u32 vertexCount()
     {
       if constexpr (IsIndexed)
         return eng::arithmeticCast<u32>(static_cast<const Derived*>(this)->vertexData().elementCount());
       else
-        return m_CommandData.vertexCount = eng::arithmeticCast<u32>(static_cast<const Derived*>(this)->vertexData().elementCount());
+        return m_CommandData.vertexCount = VertexMultiplicity() * eng::arithmeticCast<u32>(static_cast<const Derived*>(this)->vertexData().elementCount());
     }
     i32 baseVertex() const
     {
@@ -78,6 +93,23 @@ namespace eng
     }
 
     const Identifier& id() const { return m_ID; }
+
+    /*
+      \returns A hash of the command's vertex and index data. The hash is computed on first call,
+                so this should be called before data is cleared.
+    */
+    u64 contentHash()
+    {
+      if (!m_ContentHash)
+      {
+        u64 hash = static_cast<const Derived*>(this)->vertexData().contentHash();
+        if constexpr (IsIndexed)
+          hash = static_cast<const Derived*>(this)->indexData().contentHash(hash);
+        m_ContentHash = hash;
+      }
+      return *m_ContentHash;
+    }
+
     const std::shared_ptr<uSize>& commandIndex() const { return m_CommandIndex; }
 
     void setCommandIndex(uSize commandIndex) { m_CommandIndex = std::make_shared<uSize>(commandIndex); }
@@ -109,12 +141,23 @@ namespace eng
     {
       mem::RenderData data = static_cast<const Derived*>(this)->vertexData();
       if constexpr (!IsIndexed)
-        ENG_CORE_ASSERT(data.elementCount() == m_CommandData.vertexCount, "Vertex data does not have the correct number of vertices!");
+        ENG_CORE_ASSERT(VertexMultiplicity() * data.elementCount() == m_CommandData.vertexCount, "Vertex data does not have the correct number of vertices!");
       return data;
     }
     void clearData() { static_cast<Derived*>(this)->clearData(); }
 
     static constexpr bool Indexed() { return IsIndexed; }
+
+    /*
+      \returns The number of vertices drawn for each element of vertex data.
+    */
+    static constexpr u32 VertexMultiplicity()
+    {
+      if constexpr (!IsIndexed && requires { { Derived::VerticesPerElement() } -> std::convertible_to<u32>; })
+        return Derived::VerticesPerElement();
+      else
+        return 1;
+    }
   };
 
   template<typename Derived, Hashable Identifier>
@@ -133,6 +176,10 @@ namespace eng
     the type of which is user-specified. Provides fast insertion and removal, while keeping
     draw commands tightly packed. Vertex data is stored in a single dynamically-resizing buffer
     on the GPU. Additionally, the class provides operations on draw commands, such as sorting.
+
+    With IndexPolicy::SharedQuads, indexed commands are assumed to consist of quads, each of which is indexed
+    with the fixed pattern 0,1,2,1,3,2. Instead of uploading indices for every command, all commands then draw
+    from a single grow-only index buffer, offset using their base vertex.
   */
   template<DrawCommandType T>
   class MultiDrawArray
@@ -142,6 +189,8 @@ namespace eng
     static constexpr bool c_IsIndexed = T::Indexed();
 
     i32 m_Stride;
+    IndexPolicy m_IndexPolicy;
+    u32 m_SharedQuadCount;
     mem::MemoryPool m_IndexMemory;
     mem::MemoryPool m_VertexMemory;
     std::unique_ptr<VertexArray> m_VertexArray;
@@ -149,8 +198,10 @@ namespace eng
     std::unordered_map<Identifier, std::shared_ptr<uSize>> m_DrawCommandIndices;
 
   public:
-    MultiDrawArray(const mem::BufferLayout& layout)
+    MultiDrawArray(const mem::BufferLayout& layout, IndexPolicy indexPolicy = IndexPolicy::PerCommand)
       : m_Stride(layout.stride()),
+        m_IndexPolicy(indexPolicy),
+        m_SharedQuadCount(0),
         m_IndexMemory(mem::DynamicBuffer::Type::Index),
         m_VertexMemory(mem::DynamicBuffer::Type::Vertex)
     {
@@ -160,19 +211,32 @@ namespace eng
 
       if (c_IsIndexed)
         m_VertexArray->setIndexBuffer(m_IndexMemory.buffer());
+      ENG_CORE_ASSERT(c_IsIndexed || m_IndexPolicy == IndexPolicy::PerCommand, "Non-indexed draw commands cannot use shared indices!");
     }
 
     void bind() const { m_VertexArray->bind(); }
     void unbind() const { m_VertexArray->unbind(); }
 
+    /*
+      Binds vertex memory as a shader storage buffer, for shaders that pull vertex data manually.
+    */
+    void bindVertexStorage(u32 binding) const { m_VertexMemory.bindAsStorage(binding); }
+
     void insert(T&& drawCommand)
     {
       DrawCommandBaseType& baseCommand = drawCommand;
 
-      u32 elementCount = baseCommand.elementCount();
+      // Empty commands replace any existing command with the same ID
       i32 vertexCount = baseCommand.vertexCount();
+      u32 elementCount = commandElementCount(baseCommand);
       if (vertexCount == 0 || elementCount == 0)
+      {
+        remove(baseCommand.id());
         return;
+      }
+
+      // Commands identical to the resident command do not need to be re-uploaded
+      u64 contentHash = baseCommand.contentHash();
 
       auto afterUpload = [this, &baseCommand](mem::MemoryPool::AllocationResult indexAllocation, mem::MemoryPool::AllocationResult vertexAllocation)
       {
@@ -185,7 +249,11 @@ namespace eng
       DrawCommandIndicesIterator oldDrawCommandPosition = m_DrawCommandIndices.find(baseCommand.id());
       if (oldDrawCommandPosition == m_DrawCommandIndices.end())
       {
-        mem::MemoryPool::AllocationResult indexAllocation = m_IndexMemory.malloc(baseCommand.indexData());
+        mem::MemoryPool::AllocationResult indexAllocation{};
+        if (usesSharedQuadIndices())
+          indexAllocation = reserveSharedQuadIndices(elementCount);
+        else if constexpr (c_IsIndexed)
+          indexAllocation = m_IndexMemory.malloc(baseCommand.indexData());
         mem::MemoryPool::AllocationResult vertexAllocation = m_VertexMemory.malloc(baseCommand.vertexData());
         afterUpload(indexAllocation, vertexAllocation);
 
@@ -196,8 +264,14 @@ namespace eng
       else
       {
         DrawCommandBaseType& oldDrawCommand = m_DrawCommands.at(*oldDrawCommandPosition->second);
+        if (oldDrawCommand.contentHash() == contentHash)
+          return;
 
-        mem::MemoryPool::AllocationResult indexAllocation = m_IndexMemory.realloc(getDrawCommandIndicesAddress(oldDrawCommand), baseCommand.indexData());
+        mem::MemoryPool::AllocationResult indexAllocation{};
+        if (usesSharedQuadIndices())
+          indexAllocation = reserveSharedQuadIndices(elementCount);
+        else if constexpr (c_IsIndexed)
+          indexAllocation = m_IndexMemory.realloc(getDrawCommandIndicesAddress(oldDrawCommand), baseCommand.indexData());
         mem::MemoryPool::AllocationResult vertexAllocation = m_VertexMemory.realloc(getDrawCommandVerticesAddress(oldDrawCommand), baseCommand.vertexData());
         afterUpload(indexAllocation, vertexAllocation);
 
@@ -215,7 +289,8 @@ namespace eng
 
       uSize drawCommandIndex = *drawCommandToRemove->second;
       if constexpr (c_IsIndexed)
-        m_IndexMemory.free(getDrawCommandIndicesAddress(m_DrawCommands[drawCommandIndex]));
+        if (!usesSharedQuadIndices())
+          m_IndexMemory.free(getDrawCommandIndicesAddress(m_DrawCommands[drawCommandIndex]));
       m_VertexMemory.free(getDrawCommandVerticesAddress(m_DrawCommands[drawCommandIndex]));
       m_DrawCommandIndices.erase(drawCommandToRemove);
 
@@ -250,12 +325,13 @@ namespace eng
 
     /*
       Allows for a function to be applied to draw commands that modifies their indices and reuploads them to the GPU.
-      Cannot be used with non-indexed draw commands.
+      Cannot be used with non-indexed draw commands or shared quad indices.
     */
     template<InvocableWithReturnType<bool, T&> F>
     void modifyIndices(uSize drawCount, F&& function)
     {
       static_assert(c_IsIndexed);
+      ENG_CORE_ASSERT(!usesSharedQuadIndices(), "Shared quad indices cannot be modified!");
       std::for_each_n(m_DrawCommands.begin(), drawCount, [this, &function](T& drawCommand)
       {
         DrawCommandBaseType& baseCommand = drawCommand;
@@ -299,6 +375,42 @@ namespace eng
     using DrawCommandIterator = std::vector<T>::iterator;
     using DrawCommandIndicesIterator = std::unordered_map<Identifier, std::shared_ptr<uSize>>::iterator;
 
+    bool usesSharedQuadIndices() const { return c_IsIndexed && m_IndexPolicy == IndexPolicy::SharedQuads; }
+
+    u32 commandElementCount(DrawCommandBaseType& baseCommand)
+    {
+      if constexpr (c_IsIndexed)
+        if (usesSharedQuadIndices())
+          return baseCommand.quadIndexCount();
+      return baseCommand.elementCount();
+    }
+
+    /*
+      Grows the shared quad index buffer so that it holds at least the given number of indices.
+      The buffer only ever contains a single allocation, so its address never changes.
+    */
+    mem::MemoryPool::AllocationResult reserveSharedQuadIndices(u32 indexCount)
+    {
+      static constexpr mem::MemoryPool::address_t c_SharedIndicesAddress = 0;
+      static constexpr std::array<u32, 6> c_QuadIndices = { 0, 1, 2, 1, 3, 2 };
+
+      u32 quadCount = indexCount / 6;
+      if (quadCount <= m_SharedQuadCount)
+        return { c_SharedIndicesAddress, false };
+
+      u32 newQuadCount = std::max(quadCount, 2 * m_SharedQuadCount);
+      std::vector<u32> indices;
+      indices.reserve(6 * newQuadCount);
+      for (u32 quad = 0; quad < newQuadCount; ++quad)
+        for (u32 quadIndex : c_QuadIndices)
+          indices.push_back(4 * quad + quadIndex);
+
+      mem::MemoryPool::AllocationResult allocation = m_SharedQuadCount == 0 ? m_IndexMemory.malloc(indices) : m_IndexMemory.realloc(c_SharedIndicesAddress, indices);
+      ENG_CORE_ASSERT(allocation.address == c_SharedIndicesAddress, "Shared quad indices were not placed at the start of index memory!");
+      m_SharedQuadCount = newQuadCount;
+      return allocation;
+    }
+
     mem::MemoryPool::address_t getDrawCommandIndicesAddress(const DrawCommandBaseType& baseCommand)
     {
       static_assert(c_IsIndexed, "Non-indexed commands do not have an index address!");
@@ -310,7 +422,7 @@ namespace eng
       if constexpr (c_IsIndexed)
         return baseCommand.baseVertex() * m_Stride;
       else
-        return baseCommand.firstElement() * m_Stride;
+        return baseCommand.firstElement() / T::VertexMultiplicity() * m_Stride;
     }
 
     void setDrawCommandIndices(uSize begin, uSize end)
@@ -329,7 +441,7 @@ namespace eng
       }
       else
       {
-        u32 firstVertex = arithmeticCast<u32>(vertexAllocationAddress / m_Stride);
+        u32 firstVertex = T::VertexMultiplicity() * arithmeticCast<u32>(vertexAllocationAddress / m_Stride);
         baseCommand.setOffsets(firstVertex, 0);
       }
     }
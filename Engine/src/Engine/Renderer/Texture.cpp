@@ -55,6 +55,18 @@ namespace eng
     return averageColor;
   }
 
+  void Image::resize(i32 width, i32 height)
+  {
+    ENG_CORE_ASSERT(width > 0 && height > 0, "Image dimensions must be positive!");
+
+    math::ArrayBox<u8, i32> resizedData(math::IBox3<i32>(0, 0, 0, height - 1, width - 1, channels() - 1), AllocationPolicy::ForOverwrite);
+    resizedData.populate([this, width, height](const math::IVec3<i32>& index)
+    {
+      return m_Data(math::IVec3<i32>(index.i * this->height() / height, index.j * this->width() / width, index.k));
+    });
+    m_Data = std::move(resizedData);
+  }
+
 
 
   Texture::~Texture() = default;
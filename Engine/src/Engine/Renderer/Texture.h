@@ -24,6 +24,11 @@ namespace eng
     const u8* data() const;
 
     math::Float4 averageColor() const;
+
+    /*
+      Rescales the image to the given dimensions using nearest-neighbor sampling, which keeps pixel art crisp.
+    */
+    void resize(i32 width, i32 height);
   };
 
 
@@ -14,8 +14,8 @@ namespace eng::thread
     MultiDrawArray<T> m_MultiDrawArray;
 
   public:
-    AsyncMultiDrawArray(const mem::BufferLayout& layout)
-      : m_MultiDrawArray(layout) {}
+    AsyncMultiDrawArray(const mem::BufferLayout& layout, IndexPolicy indexPolicy = IndexPolicy::PerCommand)
+      : m_MultiDrawArray(layout, indexPolicy) {}
 
     template<std::invocable<eng::MultiDrawArray<T>&> F>
     void drawOperation(F&& operation)
@@ -24,6 +24,10 @@ namespace eng::thread
       operation(m_MultiDrawArray);
     }
 
+    /*
+      Queues a command to be uploaded on the next call to uploadQueuedCommands, replacing any queued command with the same ID.
+      Commands are only hashed once they are uploaded, so that commands superseded while queued are never hashed.
+    */
     void queueCommand(T&& drawCommand)
     {
       m_CommandQueue.insertOrReplace(std::move(drawCommand));
@@ -47,6 +47,12 @@ namespace eng::mem
     glBindBuffer(convertTypeToGLEnum(m_Type), 0);
   }
 
+  void OpenGLDynamicBuffer::bindAsStorage(u32 binding) const
+  {
+    ENG_CORE_ASSERT(thread::isMainThread(), "OpenGL calls must be made on the main thread!");
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, m_BufferID);
+  }
+
   DynamicBuffer::Type OpenGLDynamicBuffer::type() const { return m_Type; }
   uSize OpenGLDynamicBuffer::size() const { return m_Size; }
 
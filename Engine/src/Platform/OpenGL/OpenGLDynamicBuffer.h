@@ -15,6 +15,7 @@ namespace eng::mem
 
     void bind() const override;
     void unbind() const override;
+    void bindAsStorage(u32 binding) const override;
 
     Type type() const override;
     uSize size() const override;
@@ -39,14 +39,21 @@ void main()
                                      (a_VertexData >> 6 ) & 0x3F,
                                      (a_VertexData >> 12) & 0x3F);
 
+  // Merged quads repeat their texture once per block
   uint quadIndex = (a_VertexData >> 18) & 0x3;
-  v_TexCoord = c_TexCoords[quadIndex];
+  uint quadWidth  = ((a_Lighting >> 0) & 0x1F) + 1;
+  uint quadHeight = ((a_Lighting >> 5) & 0x1F) + 1;
+  v_TexCoord = c_TexCoords[quadIndex] * vec2(quadWidth, quadHeight);
   v_TextureIndex = (a_VertexData >> 20) & 0x3FF;
 
   uint sunlightLevel         = (a_Lighting >> 16) & 0xF;
   uint ambientOcclusionLevel = (a_Lighting >> 20) & 0x3;
+  uint blockLightLevel       = (a_Lighting >> 24) & 0xF;
 
-  float light = u_SunIntensity * float(sunlightLevel + 1) / (u_MaxSunlight + 1);
+  // Block light is independent of the time of day
+  float sunlight = u_SunIntensity * float(sunlightLevel + 1) / (u_MaxSunlight + 1);
+  float blockLight = float(blockLightLevel) / u_MaxSunlight;
+  float light = max(sunlight, blockLight);
   light *= 1.0 - 0.2 * ambientOcclusionLevel;
   v_BasicLight = vec4(vec3(light), 1.0f);
 
@@ -68,5 +75,7 @@ layout(location = 0) out vec4 o_Color;
 
 void main()
 {
-  o_Color = v_BasicLight * texture(u_TextureArray, vec3(v_TexCoord, v_TextureIndex));
+  // Explicit gradients avoid mipmap seams where fract() wraps
+  vec2 texCoord = fract(v_TexCoord);
+  o_Color = v_BasicLight * textureGrad(u_TextureArray, vec3(texCoord, v_TextureIndex), dFdx(v_TexCoord), dFdy(v_TexCoord));
 }
\ No newline at end of file
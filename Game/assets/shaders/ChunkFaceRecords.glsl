@@ -0,0 +1,101 @@
+#type vertex
+#version 460 core
+
+const vec2 c_TexCoords[4] = vec2[4]( vec2(0, 0),
+                                     vec2(1, 0),
+                                     vec2(0, 1),
+                                     vec2(1, 1) );
+
+// Must match ChunkVertex::GetOffset and ChunkVertex::GetQuadAxes
+const uvec3 c_Offsets[6][4] = uvec3[6][4]( uvec3[4]( uvec3(0, 1, 0), uvec3(0, 0, 0), uvec3(0, 1, 1), uvec3(0, 0, 1) ),
+                                           uvec3[4]( uvec3(1, 0, 0), uvec3(1, 1, 0), uvec3(1, 0, 1), uvec3(1, 1, 1) ),
+                                           uvec3[4]( uvec3(0, 0, 0), uvec3(1, 0, 0), uvec3(0, 0, 1), uvec3(1, 0, 1) ),
+                                           uvec3[4]( uvec3(1, 1, 0), uvec3(0, 1, 0), uvec3(1, 1, 1), uvec3(0, 1, 1) ),
+                                           uvec3[4]( uvec3(0, 1, 0), uvec3(1, 1, 0), uvec3(0, 0, 0), uvec3(1, 0, 0) ),
+                                           uvec3[4]( uvec3(0, 0, 1), uvec3(1, 0, 1), uvec3(0, 1, 1), uvec3(1, 1, 1) ) );
+const uvec2 c_QuadAxes[6] = uvec2[6]( uvec2(1, 2), uvec2(1, 2), uvec2(0, 2), uvec2(0, 2), uvec2(0, 1), uvec2(0, 1) );
+
+// Must match ChunkDrawCommand::addQuad and ChunkDrawCommand::addQuadIndices
+const uint c_QuadPositions[6] = uint[6]( 0, 1, 2, 1, 3, 2 );
+const uint c_StandardOrder[4] = uint[4]( 0, 1, 2, 3 );
+const uint c_ReversedOrder[4] = uint[4]( 1, 3, 0, 2 );
+
+layout(std140, binding = 0) uniform Camera
+{
+  mat4 u_ViewProjection;
+  vec3 u_CameraPosition;
+};
+layout(std140, binding = 1) uniform Block
+{
+  float u_BlockLength;
+};
+layout(std140, binding = 2) uniform Light
+{
+  float u_MaxSunlight;
+  float u_SunIntensity;
+};
+layout(std430, binding = 1) buffer ChunkAnchors
+{
+  vec4 u_AnchorPosition[];
+};
+layout(std430, binding = 3) readonly buffer ChunkFaceRecords
+{
+  uvec2 u_FaceRecords[];
+};
+
+layout(location = 0) out flat uint v_TextureIndex;
+layout(location = 1) out vec2 v_TexCoord;
+layout(location = 2) out vec4 v_BasicLight;
+
+void main()
+{
+  // Each face record is expanded into two triangles, see ChunkFaceRecord for layout
+  uvec2 record = u_FaceRecords[gl_VertexID / 6];
+  uint face = (record.x >> 15) & 0x7;
+  bool reversedSeam = ((record.x >> 31) & 0x1) != 0;
+  uint quadPosition = c_QuadPositions[gl_VertexID % 6];
+  uint quadIndex = reversedSeam ? c_ReversedOrder[quadPosition] : c_StandardOrder[quadPosition];
+
+  uvec2 quadExtents = uvec2(((record.x >> 26) & 0x1F) + 1, (record.y & 0x1F) + 1);
+  uvec3 offset = c_Offsets[face][quadIndex];
+  offset[c_QuadAxes[face].x] *= quadExtents.x;
+  offset[c_QuadAxes[face].y] *= quadExtents.y;
+
+  // Relative position of vertex
+  uvec3 blockIndex = uvec3((record.x >> 0) & 0x1F, (record.x >> 5) & 0x1F, (record.x >> 10) & 0x1F);
+  vec3 relPos = u_BlockLength * vec3(blockIndex + offset);
+
+  // Merged quads repeat their texture once per block
+  v_TexCoord = c_TexCoords[quadIndex] * vec2(quadExtents);
+  v_TextureIndex = (record.x >> 18) & 0xFF;
+
+  // Records store the brighter of sunlight and block light
+  uint lightLevel            = (record.y >> (5 + 4 * quadIndex )) & 0xF;
+  uint ambientOcclusionLevel = (record.y >> (21 + 2 * quadIndex)) & 0x3;
+
+  float light = u_SunIntensity * float(lightLevel + 1) / (u_MaxSunlight + 1);
+  light *= 1.0 - 0.2 * ambientOcclusionLevel;
+  v_BasicLight = vec4(vec3(light), 1.0f);
+
+  gl_Position = u_ViewProjection * vec4(u_AnchorPosition[gl_DrawID].xyz + relPos, 1.0f);
+}
+
+
+
+#type fragment
+#version 460 core
+
+layout(binding = 0) uniform sampler2DArray u_TextureArray;
+
+layout(location = 0) in flat uint v_TextureIndex;
+layout(location = 1) in vec2 v_TexCoord;
+layout(location = 2) in vec4 v_BasicLight;
+
+layout(location = 0) out vec4 o_Color;
+
+void main()
+{
+  // Explicit gradients avoid mipmap seams where fract() wraps
+  vec2 texCoord = fract(v_TexCoord);
+  o_Color = v_BasicLight * textureGrad(u_TextureArray, vec3(texCoord, v_TextureIndex), dFdx(v_TexCoord), dFdy(v_TexCoord));
+}
\ No newline at end of file
@@ -1,87 +1,9 @@
 #include "GMpch.h"
 #include "Block.h"
+#include "Engine/Core/Simd.h"
 
 namespace block
 {
-  static constexpr eng::EnumArray<bool, ID> computeTransparencies()
-  {
-    eng::EnumArray<bool, ID> transparencies{};
-    for (ID blockID : IDs())
-    {
-      switch (blockID)
-      {
-        case ID::Air:
-        case ID::OakLeaves:
-        case ID::FallLeaves:
-        case ID::Glass:
-        case ID::Water:
-          transparencies[blockID] = true;
-          break;
-        default: transparencies[blockID] = false;
-      }
-    }
-    return transparencies;
-  }
-
-  static constexpr eng::EnumArray<bool, ID> computeCollisionalities()
-  {
-    eng::EnumArray<bool, ID> collisionalities{};
-    for (ID blockID : IDs())
-    {
-      switch (blockID)
-      {
-        case ID::Air:
-        case ID::Water:
-          collisionalities[blockID] = false;
-          break;
-        default: collisionalities[blockID] = true;
-      }
-    }
-    return collisionalities;
-  }
-
-  static constexpr eng::EnumArray<TextureID, eng::math::Direction> createBlockTextures(TextureID westTexture,   TextureID eastTexture,
-                                                                                       TextureID southTexture,  TextureID northTexture,
-                                                                                       TextureID bottomTexture, TextureID topTexture)
-  {
-    return { { eng::math::Direction::West,   westTexture   }, { eng::math::Direction::East,  eastTexture  },
-             { eng::math::Direction::South,  southTexture  }, { eng::math::Direction::North, northTexture },
-             { eng::math::Direction::Bottom, bottomTexture }, { eng::math::Direction::Top,   topTexture   } };
-  }
-
-  static constexpr eng::EnumArray<TextureID, eng::math::Direction> createBlockTextures(TextureID topTexture, TextureID sideTextures, TextureID bottomTexture)
-  {
-    return createBlockTextures(sideTextures, sideTextures, sideTextures, sideTextures, bottomTexture, topTexture);
-  }
-
-  static constexpr eng::EnumArray<TextureID, eng::math::Direction> createBlockTextures(TextureID topBotTextures, TextureID sideTextures)
-  {
-    return createBlockTextures(topBotTextures, sideTextures, topBotTextures);
-  }
-
-  static constexpr eng::EnumArray<TextureID, eng::math::Direction> createBlockTextures(TextureID faceTextures)
-  {
-    return createBlockTextures(faceTextures, faceTextures);
-  }
-
-  static constexpr eng::EnumArray<eng::EnumArray<TextureID, eng::math::Direction>, ID> computeTextureIDs()
-  {
-    return { { ID::Air, createBlockTextures(TextureID::Invisible) },
-             { ID::Grass, createBlockTextures(TextureID::GrassTop, TextureID::GrassSide, TextureID::Dirt) },
-             { ID::Dirt, createBlockTextures(TextureID::Dirt) },
-             { ID::Clay, createBlockTextures(TextureID::Clay) },
-             { ID::Gravel, createBlockTextures(TextureID::Gravel) },
-             { ID::Sand, createBlockTextures(TextureID::Sand) },
-             { ID::Snow, createBlockTextures(TextureID::Snow) },
-             { ID::Stone, createBlockTextures(TextureID::Stone) },
-             { ID::OakLog, createBlockTextures(TextureID::OakLogTop, TextureID::OakLogSide) },
-             { ID::OakLeaves, createBlockTextures(TextureID::OakLeaves) },
-             { ID::FallLeaves, createBlockTextures(TextureID::FallLeaves) },
-             { ID::Glass, createBlockTextures(TextureID::Glass) },
-             { ID::Water, createBlockTextures(TextureID::Water) },
-             { ID::Null, createBlockTextures(TextureID::ErrorTexture) } };
-  }
-
   static eng::EnumArray<std::filesystem::path, TextureID> computeTexturePaths()
   {
     std::filesystem::path textureFolder = "assets/textures";
@@ -101,6 +23,8 @@ namespace block
              { TextureID::FallLeaves, tileFolder / "leaves_orange_transparent.png" },
              { TextureID::Glass, tileFolder / "glass.png" },
              { TextureID::Water, tileFolder / "water_transparent.png" },
+             { TextureID::Glowstone, textureFolder / "TetraPack/blocks/glowstone.png" },
+             { TextureID::Torch, textureFolder / "TetraPack/blocks/torch_on.png" },
              { TextureID::Invisible, textureFolder / "Invisible.png" },
              { TextureID::ErrorTexture, textureFolder / "Checkerboard.png" } };
   }
@@ -112,22 +36,10 @@ namespace block
     const f32 blockLength = lengthF();
   };
 
-  struct BlockProperties
-  {
-    eng::EnumArray<bool, ID> hasTransparency;
-    eng::EnumArray<bool, ID> hasCollision;
-    eng::EnumArray<eng::EnumArray<TextureID, eng::math::Direction>, ID> textureIDs;
-
-    constexpr BlockProperties()
-    {
-      hasTransparency = computeTransparencies();
-      hasCollision = computeCollisionalities();
-      textureIDs = computeTextureIDs();
-    }
-  };
-  static constexpr BlockProperties s_Properties;
   
   static constexpr i32 c_UniformBinding = 1;
+  static constexpr i32 c_MaxTextures = 32;
+  static constexpr i32 c_TextureSize = 128;
   static constexpr i32 c_SSBOBinding = 0;
   static constexpr BlockUniformData c_BlockUniformData;
 
@@ -146,7 +58,7 @@ namespace block
 
       s_TexturePaths = computeTexturePaths();
 
-      s_TextureArray = eng::TextureArray::Create(16, 128);
+      s_TextureArray = eng::TextureArray::Create(c_MaxTextures, c_TextureSize);
       eng::EnumArray<eng::math::Float4, TextureID> textureAverageColors;
       for (TextureID texture : Textures())
       {
@@ -157,6 +69,8 @@ namespace block
         }
 
         eng::Image textureImage(s_TexturePaths[texture]);
+        if (textureImage.width() != c_TextureSize || textureImage.height() != c_TextureSize)
+          textureImage.resize(c_TextureSize, c_TextureSize);
         s_TextureArray->addTexture(textureImage);
 
         eng::math::Float4 textureAverageColor = textureImage.averageColor();
@@ -166,7 +80,7 @@ namespace block
 
       for (ID blockID : IDs())
         for (eng::math::Direction blockFace : eng::math::Directions())
-          s_BlockAverageColors[blockID][blockFace] = textureAverageColors[s_Properties.textureIDs[blockID][blockFace]];
+          s_BlockAverageColors[blockID][blockFace] = textureAverageColors[Type(blockID).texture(blockFace)];
 
       eng::mem::RenderData textureAverageColorsData(s_BlockAverageColors);
       s_SSBO = std::make_unique<eng::ShaderBufferStorage>(c_SSBOBinding, textureAverageColorsData.size());
@@ -187,38 +101,138 @@ namespace block
     initialize();
   }
 
-  TextureID Type::texture(eng::math::Direction face) const
+  static constexpr std::array<u8, 16> computeOpacityShuffleTable()
   {
-    return s_Properties.textureIDs[m_TypeID][face];
+    std::array<u8, 16> opacityTable{};
+    for (ID blockID : IDs())
+      opacityTable[eng::enumIndex(blockID)] = Type(blockID).hasTransparency() ? 0x00 : 0xFF;
+    return opacityTable;
   }
+  alignas(16) static constexpr std::array<u8, 16> c_OpacityShuffleTable = computeOpacityShuffleTable();
 
-  bool Type::hasTransparency() const
+  u64 opacityMask(std::span<const Type> types)
   {
-    return s_Properties.hasTransparency[m_TypeID];
+    ENG_ASSERT(types.size() <= 64, "Type span is too large to fit in a 64-bit mask!");
+    static_assert(sizeof(Type) == sizeof(ID) && sizeof(ID) == 1, "Block types must be tightly packed bytes!");
+    static_assert(eng::enumCount<ID>() <= 16, "Block opacity table no longer fits in a single shuffle register!");
+
+    const u8* typeBytes = reinterpret_cast<const u8*>(types.data());
+    u64 mask = 0;
+    uSize n = 0;
+
+#if defined(ENG_SIMD_SSSE3)
+    // Opacity of each block ID, looked up 16 types at a time with a byte shuffle
+    __m128i opacityLookup = _mm_load_si128(reinterpret_cast<const __m128i*>(c_OpacityShuffleTable.data()));
+
+  #if defined(ENG_SIMD_AVX2)
+    __m256i opacityLookupWide = _mm256_broadcastsi128_si256(opacityLookup);
+    for (; n + 32 <= types.size(); n += 32)
+    {
+      __m256i ids = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(typeBytes + n));
+      u32 opaque = static_cast<u32>(_mm256_movemask_epi8(_mm256_shuffle_epi8(opacityLookupWide, ids)));
+      mask |= static_cast<u64>(opaque) << n;
+    }
+  #endif
+    for (; n + 16 <= types.size(); n += 16)
+    {
+      __m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i*>(typeBytes + n));
+      u32 opaque = static_cast<u32>(_mm_movemask_epi8(_mm_shuffle_epi8(opacityLookup, ids)));
+      mask |= static_cast<u64>(opaque) << n;
+    }
+#endif
+
+    for (; n < types.size(); ++n)
+      mask |= static_cast<u64>(c_Properties.opacity >> typeBytes[n] & 1) << n;
+    return mask;
   }
 
-  bool Type::hasCollision() const
+  u64 matchMask(std::span<const Type> types, Type type)
   {
-    return s_Properties.hasCollision[m_TypeID];
+    ENG_ASSERT(types.size() <= 64, "Type span is too large to fit in a 64-bit mask!");
+
+    const u8* typeBytes = reinterpret_cast<const u8*>(types.data());
+    u8 typeByte = eng::toUnderlying(type.id());
+    u64 mask = 0;
+    uSize n = 0;
+
+#if defined(ENG_SIMD_SSE2)
+    __m128i target = _mm_set1_epi8(typeByte);
+    for (; n + 16 <= types.size(); n += 16)
+    {
+      __m128i ids = _mm_loadu_si128(reinterpret_cast<const __m128i*>(typeBytes + n));
+      u32 matches = static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(ids, target)));
+      mask |= static_cast<u64>(matches) << n;
+    }
+#endif
+
+    for (; n < types.size(); ++n)
+      mask |= static_cast<u64>(typeBytes[n] == typeByte) << n;
+    return mask;
   }
 
 
 
+  static constexpr u8 c_SunlightMask = 0x0F;
+  static constexpr u8 c_BlockLightMask = 0xF0;
+  static constexpr u8 c_ChannelLowBits = 0x11;
+
   Light::Light()
     : Light(0) {}
   Light::Light(i8 sunlight)
-    : m_Sunlight(sunlight)
+    : Light(sunlight, 0) {}
+  Light::Light(i8 sunlight, i8 blockLight)
+    : m_Data(static_cast<u8>(sunlight | blockLight << 4))
   {
     ENG_ASSERT(eng::withinBounds(sunlight, 0, MaxValue() + 1), "Invalid value for sunlight!");
+    ENG_ASSERT(eng::withinBounds(blockLight, 0, MaxValue() + 1), "Invalid value for block light!");
   }
 
   bool Light::operator==(Light other) const
   {
-    return m_Sunlight == other.m_Sunlight;
+    return m_Data == other.m_Data;
   }
 
   i8 Light::sunlight() const
   {
-    return m_Sunlight;
+    return static_cast<i8>(m_Data & c_SunlightMask);
+  }
+
+  i8 Light::blockLight() const
+  {
+    return static_cast<i8>(m_Data >> 4);
+  }
+
+  i8 Light::intensity() const
+  {
+    return std::max(sunlight(), blockLight());
+  }
+
+  Light Light::propagated(eng::math::Direction direction) const
+  {
+    // Low bit of each channel that is non-zero, so that subtracting never borrows across channels
+    u8 nonZeroChannels = (m_Data | m_Data >> 1 | m_Data >> 2 | m_Data >> 3) & c_ChannelLowBits;
+    if (direction == eng::math::Direction::Bottom && sunlight() == MaxValue())
+      nonZeroChannels &= c_BlockLightMask;
+
+    Light propagatedLight;
+    propagatedLight.m_Data = static_cast<u8>(m_Data - nonZeroChannels);
+    return propagatedLight;
+  }
+
+  Light Light::Max(Light lightA, Light lightB)
+  {
+    // Spread channels into separate bytes, leaving room for a guard bit above each channel
+    auto spread = [](u8 data) { return static_cast<u32>((data & c_SunlightMask) | (data & c_BlockLightMask) << 4); };
+    u32 a = spread(lightA.m_Data);
+    u32 b = spread(lightB.m_Data);
+
+    // Guard bit of each byte survives the subtraction only where the channel of A is at least that of B
+    u32 aGreaterEqual = ((a | 0x1010) - b) >> 4 & 0x0101;
+    u32 channelMask = aGreaterEqual * 0x0F;
+    u32 maxChannels = (a & channelMask) | (b & ~channelMask & 0x0F0F);
+
+    Light maxLight;
+    maxLight.m_Data = static_cast<u8>((maxChannels & 0x0F) | (maxChannels >> 4 & c_BlockLightMask));
+    return maxLight;
   }
 }
\ No newline at end of file
@@ -10,6 +10,144 @@ namespace block
   std::shared_ptr<eng::TextureArray> getTextureArray();
   void bindAverageColorSSBO();
 
+  namespace detail
+  {
+    constexpr eng::EnumArray<bool, ID> computeTransparencies()
+    {
+      eng::EnumArray<bool, ID> transparencies{};
+      for (ID blockID : IDs())
+      {
+        switch (blockID)
+        {
+          case ID::Air:
+          case ID::OakLeaves:
+          case ID::FallLeaves:
+          case ID::Glass:
+          case ID::Water:
+          case ID::Torch:
+            transparencies[blockID] = true;
+            break;
+          default: transparencies[blockID] = false;
+        }
+      }
+      return transparencies;
+    }
+
+    constexpr eng::EnumArray<bool, ID> computeCollisionalities()
+    {
+      eng::EnumArray<bool, ID> collisionalities{};
+      for (ID blockID : IDs())
+      {
+        switch (blockID)
+        {
+          case ID::Air:
+          case ID::Water:
+          case ID::Torch:
+            collisionalities[blockID] = false;
+            break;
+          default: collisionalities[blockID] = true;
+        }
+      }
+      return collisionalities;
+    }
+
+    constexpr eng::EnumArray<i8, ID> computeLightEmissions()
+    {
+      eng::EnumArray<i8, ID> lightEmissions{};
+      for (ID blockID : IDs())
+      {
+        switch (blockID)
+        {
+          case ID::Glowstone: lightEmissions[blockID] = 15; break;
+          case ID::Torch:     lightEmissions[blockID] = 14; break;
+          default:            lightEmissions[blockID] = 0;
+        }
+      }
+      return lightEmissions;
+    }
+
+    constexpr eng::EnumArray<TextureID, eng::math::Direction> createBlockTextures(TextureID westTexture,   TextureID eastTexture,
+                                                                                  TextureID southTexture,  TextureID northTexture,
+                                                                                  TextureID bottomTexture, TextureID topTexture)
+    {
+      return { { eng::math::Direction::West,   westTexture   }, { eng::math::Direction::East,  eastTexture  },
+               { eng::math::Direction::South,  southTexture  }, { eng::math::Direction::North, northTexture },
+               { eng::math::Direction::Bottom, bottomTexture }, { eng::math::Direction::Top,   topTexture   } };
+    }
+
+    constexpr eng::EnumArray<TextureID, eng::math::Direction> createBlockTextures(TextureID topTexture, TextureID sideTextures, TextureID bottomTexture)
+    {
+      return createBlockTextures(sideTextures, sideTextures, sideTextures, sideTextures, bottomTexture, topTexture);
+    }
+
+    constexpr eng::EnumArray<TextureID, eng::math::Direction> createBlockTextures(TextureID topBotTextures, TextureID sideTextures)
+    {
+      return createBlockTextures(topBotTextures, sideTextures, topBotTextures);
+    }
+
+    constexpr eng::EnumArray<TextureID, eng::math::Direction> createBlockTextures(TextureID faceTextures)
+    {
+      return createBlockTextures(faceTextures, faceTextures);
+    }
+
+    constexpr eng::EnumArray<eng::EnumArray<TextureID, eng::math::Direction>, ID> computeTextureIDs()
+    {
+      return { { ID::Air, createBlockTextures(TextureID::Invisible) },
+               { ID::Grass, createBlockTextures(TextureID::GrassTop, TextureID::GrassSide, TextureID::Dirt) },
+               { ID::Dirt, createBlockTextures(TextureID::Dirt) },
+               { ID::Clay, createBlockTextures(TextureID::Clay) },
+               { ID::Gravel, createBlockTextures(TextureID::Gravel) },
+               { ID::Sand, createBlockTextures(TextureID::Sand) },
+               { ID::Snow, createBlockTextures(TextureID::Snow) },
+               { ID::Stone, createBlockTextures(TextureID::Stone) },
+               { ID::OakLog, createBlockTextures(TextureID::OakLogTop, TextureID::OakLogSide) },
+               { ID::OakLeaves, createBlockTextures(TextureID::OakLeaves) },
+               { ID::FallLeaves, createBlockTextures(TextureID::FallLeaves) },
+               { ID::Glass, createBlockTextures(TextureID::Glass) },
+               { ID::Water, createBlockTextures(TextureID::Water) },
+               { ID::Glowstone, createBlockTextures(TextureID::Glowstone) },
+               { ID::Torch, createBlockTextures(TextureID::Torch) },
+               { ID::Null, createBlockTextures(TextureID::ErrorTexture) } };
+    }
+
+    constexpr u32 computeBitset(const eng::EnumArray<bool, ID>& properties)
+    {
+      u32 bitset = 0;
+      for (ID blockID : IDs())
+        if (properties[blockID])
+          bitset |= eng::u32Bit(eng::enumIndex(blockID));
+      return bitset;
+    }
+  }
+
+  /*
+    Block properties stored as flat lookup tables indexed by block ID. Boolean properties are packed
+    into bitsets, where bit n corresponds to the block with ID index n. Textures are stored per face,
+    so that a single face direction can be looked up for many blocks from one contiguous table.
+  */
+  struct PropertyTables
+  {
+    u32 opacity;
+    u32 collision;
+    eng::EnumArray<i8, ID> lightEmission;
+    eng::EnumArray<eng::EnumArray<TextureID, ID>, eng::math::Direction> textures;
+
+    constexpr PropertyTables()
+      : opacity(~detail::computeBitset(detail::computeTransparencies()) & (eng::u32Bit(eng::enumCount<ID>()) - 1)),
+        collision(detail::computeBitset(detail::computeCollisionalities())),
+        lightEmission(detail::computeLightEmissions()),
+        textures()
+    {
+      static_assert(eng::enumCount<ID>() <= 32, "Block property bitsets only support up to 32 block IDs!");
+
+      eng::EnumArray<eng::EnumArray<TextureID, eng::math::Direction>, ID> textureIDs = detail::computeTextureIDs();
+      for (ID blockID : IDs())
+        for (eng::math::Direction face : eng::math::Directions())
+          textures[face][blockID] = textureIDs[blockID][face];
+    }
+  };
+  constexpr PropertyTables c_Properties;
+
   class Type
   {
     ID m_TypeID;
@@ -25,23 +163,59 @@ namespace block
 
     constexpr ID id() const { return m_TypeID; }
   
-    TextureID texture(eng::math::Direction face) const;
+    constexpr TextureID texture(eng::math::Direction face) const { return c_Properties.textures[face][m_TypeID]; }
   
-    bool hasTransparency() const;
-    bool hasCollision() const;
+    constexpr bool hasTransparency() const { return !(c_Properties.opacity & eng::u32Bit(eng::enumIndex(m_TypeID))); }
+    constexpr bool hasCollision() const { return c_Properties.collision & eng::u32Bit(eng::enumIndex(m_TypeID)); }
+    constexpr i8 lightEmission() const { return c_Properties.lightEmission[m_TypeID]; }
   };
 
+  /*
+    Packs the opacity of each block in the given span into a bitmask, where bit n is set if the
+    n-th block is opaque. Spans can be at most 64 blocks long.
+  */
+  u64 opacityMask(std::span<const Type> types);
+
+  /*
+    Packs a bitmask where bit n is set if the n-th block in the given span is of the specified type.
+    Spans can be at most 64 blocks long.
+  */
+  u64 matchMask(std::span<const Type> types, Type type);
+
+  /*
+    Light level of a block, made up of sunlight and light emitted by blocks. Both channels are
+    packed into a single byte, with sunlight in the low nibble and block light in the high nibble,
+    so that they can be propagated together by operating on both nibbles at once.
+  */
   class Light
   {
-    i8 m_Sunlight;
+    u8 m_Data;
 
   public:
     Light();
     Light(i8 sunlight);
+    Light(i8 sunlight, i8 blockLight);
 
     bool operator==(Light other) const;
 
     i8 sunlight() const;
+    i8 blockLight() const;
+
+    /*
+      \returns The brighter of the two channels.
+    */
+    i8 intensity() const;
+
+    /*
+      \returns The light received by the neighbor in the given direction. Each channel is attenuated
+               by one, except for full sunlight, which travels downward without attenuation.
+    */
+    Light propagated(eng::math::Direction direction) const;
+
+    /*
+      \returns The maximum of each channel.
+    */
+    static Light Max(Light lightA, Light lightB);
 
     static constexpr i8 MaxValue() { return 15; }
   };
@@ -18,6 +18,8 @@ namespace block
     FallLeaves,
     Glass,
     Water,
+    Glowstone,
+    Torch,
 
     Null,
     First = 0, Last = Null
@@ -40,6 +42,8 @@ namespace block
     FallLeaves,
     Glass,
     Water,
+    Glowstone,
+    Torch,
 
     Invisible,
     ErrorTexture,
@@ -9,6 +9,10 @@ namespace param
 
   constexpr length_t BlockLength() { return 0.5_m; }
   constexpr i32 ChunkSize() { return 32; }
+  constexpr i32 ChunkSectionSize() { return 16; }
+  constexpr bool GreedyMeshing() { return true; }
+  constexpr bool FaceRecordMeshes() { return false; }
+  constexpr bool SharedQuadIndices() { return true; }
 
   constexpr i32 MaxNodeDepth() { return 16; }
   constexpr i32 HighestRenderableLODLevel() { return 12; }
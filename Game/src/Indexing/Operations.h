@@ -58,4 +58,18 @@ constexpr LocalBox affectedChunks(const BlockBox& chunkSection, blockIndex_t inf
 constexpr LocalBox affectedChunks(const BlockIndex& blockIndex, blockIndex_t influenceRadius = 1)
 {
   return affectedChunks(BlockBox(blockIndex, blockIndex), influenceRadius);
+}
+
+/*
+  \returns Bit mask of the sections of a chunk whose meshes can be affected by a change to the given block. Meshes
+           depend on the blocks bordering their section, so the block may lie up to one block outside of the chunk.
+*/
+constexpr u64 affectedSections(const BlockIndex& blockIndex)
+{
+  BlockBox affectedBlocks = BlockBox::Intersection(Chunk::Bounds(), BlockBox(blockIndex, blockIndex).expand());
+
+  u64 sectionMask = 0;
+  for (const BlockIndex& sectionIndex : affectedBlocks.flooredDivide(Chunk::SectionSize()))
+    sectionMask |= eng::u64Bit(Chunk::SectionOf(Chunk::SectionSize() * sectionIndex));
+  return sectionMask;
 }
\ No newline at end of file
@@ -6,7 +6,16 @@ Chunk::Chunk(const GlobalIndex& chunkIndex)
   : m_Composition(Bounds(), block::ID::Air),
     m_Lighting(Bounds(), block::Light::MaxValue()),
     m_NonOpaqueFaces(0x3F),
-    m_GlobalIndex(chunkIndex) {}
+    m_State(State::Generated),
+    m_ActiveLightingEdits(0),
+    m_LightingVersion(0),
+    m_GlobalIndex(chunkIndex)
+{
+  for (std::atomic<blockIndex_t>& columnHeight : m_Heightmap)
+    columnHeight.store(-1);
+  for (std::atomic<u32>& rowExposure : m_SkyExposure)
+    rowExposure.store(~0U);
+}
 
 const GlobalIndex& Chunk::globalIndex() const
 {
@@ -49,9 +58,104 @@ bool Chunk::isFaceOpaque(eng::math::Direction face) const
   return !(nonOpaqueFaces & eng::bit(eng::enumIndex(face)));
 }
 
+blockIndex_t Chunk::topOpaqueBlock(const BlockIndex2D& column) const
+{
+  return m_Heightmap[Size() * column.i + column.j].load();
+}
+
+bool Chunk::isSkyExposed(const BlockIndex2D& column) const
+{
+  return m_SkyExposure[column.i].load() & eng::u32Bit(column.j);
+}
+
+Chunk::ColumnMask Chunk::skyExposure() const
+{
+  ColumnMask skyExposure{};
+  for (blockIndex_t i = 0; i < Size(); ++i)
+    skyExposure[i] = m_SkyExposure[i].load();
+  return skyExposure;
+}
+
+Chunk::ColumnMask Chunk::transparentColumns() const
+{
+  ColumnMask transparentColumns{};
+  for (const BlockIndex2D& column : Bounds2D())
+    if (topOpaqueBlock(column) < 0)
+      transparentColumns[column.i] |= eng::u32Bit(column.j);
+  return transparentColumns;
+}
+
+bool Chunk::setSkyExposure(const ColumnMask& skyExposure)
+{
+  bool exposureChanged = false;
+  for (blockIndex_t i = 0; i < Size(); ++i)
+    exposureChanged |= m_SkyExposure[i].exchange(skyExposure[i]) != skyExposure[i];
+  return exposureChanged;
+}
+
+bool Chunk::updateHeightmap(const BlockIndex& blockIndex)
+{
+  std::atomic<blockIndex_t>& columnHeight = m_Heightmap[Size() * blockIndex.i + blockIndex.j];
+  bool blockIsOpaque = !m_Composition.get(blockIndex).hasTransparency();
+
+  // The new height is derived from the current one, so it is recomputed if another edit changed the column in the meantime
+  blockIndex_t previousHeight = columnHeight.load();
+  blockIndex_t newHeight;
+  do
+  {
+    newHeight = previousHeight;
+    if (blockIsOpaque)
+      newHeight = std::max(previousHeight, blockIndex.k);
+    else if (blockIndex.k == previousHeight)
+    {
+      // Topmost opaque block was removed, search downward for the next one
+      newHeight = m_Composition.readOperation([&blockIndex](const BlockArrayBox<block::Type>& arrayBox)
+      {
+        blockIndex_t k = blockIndex.k - 1;
+        while (arrayBox && k >= 0 && arrayBox(BlockIndex(blockIndex.i, blockIndex.j, k)).hasTransparency())
+          --k;
+        return arrayBox ? k : -1;
+      });
+    }
+  } while (!columnHeight.compare_exchange_weak(previousHeight, newHeight));
+
+  return (previousHeight < 0) != (newHeight < 0);
+}
+
+Chunk::State Chunk::state() const
+{
+  return m_State.load();
+}
+
+bool Chunk::advanceState(State expected, State desired)
+{
+  return m_State.compare_exchange_strong(expected, desired);
+}
+
+void Chunk::beginLightingEdit()
+{
+  // The edit is marked active before the version changes, so that a reader who sees the new version also sees the active edit
+  ++m_ActiveLightingEdits;
+  ++m_LightingVersion;
+}
+
+void Chunk::endLightingEdit()
+{
+  --m_ActiveLightingEdits;
+}
+
+std::optional<u32> Chunk::lightingVersion() const
+{
+  u32 version = m_LightingVersion.load();
+  if (m_ActiveLightingEdits.load() > 0)
+    return std::nullopt;
+  return version;
+}
+
 void Chunk::setComposition(BlockArrayBox<block::Type>&& composition)
 {
   m_Composition.setData(std::move(composition));
+  calculateHeightmap();
   determineOpacity();
 }
 
@@ -73,6 +177,14 @@ void Chunk::determineOpacity()
     u16 nonOpaqueFaces = 0;
     for (eng::math::Direction direction : eng::math::Directions())
     {
+      // The top face is only opaque if every column is capped by an opaque block
+      if (direction == eng::math::Direction::Top)
+      {
+        if (eng::algo::anyOf(Bounds2D(), [this](const BlockIndex2D& column) { return topOpaqueBlock(column) != Size() - 1; }))
+          nonOpaqueFaces |= eng::bit(eng::enumIndex(direction));
+        continue;
+      }
+
       BlockBox face = Bounds().face(direction);
       if (arrayBox.anyOf(face, [](block::Type blockType) { return blockType.hasTransparency(); }))
         nonOpaqueFaces |= eng::bit(eng::enumIndex(direction));
@@ -81,6 +193,20 @@ void Chunk::determineOpacity()
   });
 }
 
+void Chunk::calculateHeightmap()
+{
+  m_Composition.readOperation([this](const BlockArrayBox<block::Type>& arrayBox)
+  {
+    for (const BlockIndex2D& column : Bounds2D())
+    {
+      blockIndex_t k = Size() - 1;
+      while (arrayBox && k >= 0 && arrayBox(BlockIndex(column, k)).hasTransparency())
+        --k;
+      m_Heightmap[Size() * column.i + column.j].store(arrayBox ? k : -1);
+    }
+  });
+}
+
 void Chunk::update()
 {
   m_Composition.clearIfFilledWithDefault();
@@ -7,12 +7,37 @@
 */
 class Chunk : private eng::SetInStone
 {
+public:
+  /*
+    Stages of a chunk's lifecycle. A newly generated chunk waits until none of its missing stencil neighbors can
+    still affect it, after which it is lit and meshed once. From then on, it is only updated in response to edits
+    and to neighbors that load late.
+  */
+  enum class State : u8
+  {
+    Generated,
+    Ready,
+    Lit,
+    Meshed
+  };
+
+private:
   ProtectedBlockArrayBox<block::Type> m_Composition;
   ProtectedBlockArrayBox<block::Light> m_Lighting;
   std::atomic<u16> m_NonOpaqueFaces;
+  std::atomic<State> m_State;
+  std::atomic<i32> m_ActiveLightingEdits;
+  std::atomic<u32> m_LightingVersion;
+  std::array<std::atomic<blockIndex_t>, eng::math::square(param::ChunkSize())> m_Heightmap;
+  std::array<std::atomic<u32>, param::ChunkSize()> m_SkyExposure;
   GlobalIndex m_GlobalIndex;
 
 public:
+  /*
+    Bitmask over the columns of a chunk, where bit j of row i corresponds to column (i, j).
+  */
+  using ColumnMask = std::array<u32, param::ChunkSize()>;
+
   Chunk() = delete;
   explicit Chunk(const GlobalIndex& chunkIndex);
 
@@ -60,9 +85,57 @@ public:
   */
   bool isFaceOpaque(eng::math::Direction face) const;
 
+  /*
+    \returns The height of the topmost opaque block in the given column, or -1 if the column has no opaque blocks.
+  */
+  blockIndex_t topOpaqueBlock(const BlockIndex2D& column) const;
+
+  /*
+    \returns Whether sunlight reaches the top of the given column, meaning that no loaded chunk above blocks the sky.
+  */
+  bool isSkyExposed(const BlockIndex2D& column) const;
+
+  ColumnMask skyExposure() const;
+  ColumnMask transparentColumns() const;
+
+  /*
+    \returns True if the sky exposure of the chunk changed.
+  */
+  bool setSkyExposure(const ColumnMask& skyExposure);
+
+  /*
+    Updates the heightmap after a block has been changed.
+
+    \returns True if the column of the block gained its first opaque block or lost its last one,
+             which changes the sky exposure of the chunks below.
+  */
+  bool updateHeightmap(const BlockIndex& blockIndex);
+
+  State state() const;
+
+  /*
+    Moves the chunk to the given state if it is currently in the expected state.
+
+    \returns True if the state was changed.
+  */
+  bool advanceState(State expected, State desired);
+
+  /*
+    Brackets edits that write directly into the chunk's lighting, such as light propagation after a block update.
+    A full relight replaces the lighting wholesale, so it uses lightingVersion() to detect edits it may have overwritten.
+  */
+  void beginLightingEdit();
+  void endLightingEdit();
+
+  /*
+    \returns A version that changes whenever a lighting edit begins, or std::nullopt while an edit is in progress.
+  */
+  std::optional<u32> lightingVersion() const;
+
   void setComposition(BlockArrayBox<block::Type>&& composition);
   void setLighting(BlockArrayBox<block::Light>&& lighting);
   void determineOpacity();
+  void calculateHeightmap();
 
   void update();
 
@@ -73,4 +146,25 @@ public:
   static constexpr BlockBox Bounds() { return BlockBox(0, Size() - 1); }
   static constexpr BlockRect Bounds2D() { return BlockRect(0, Size() - 1); }
   static constexpr GlobalBox Stencil(const GlobalIndex& chunkIndex) { return GlobalBox(chunkIndex, chunkIndex).expand(); }
-};
\ No newline at end of file
+
+  /*
+    Chunks are split into cubic sections for meshing, so that small edits only need to re-mesh and re-upload
+    the sections they touch. Sections are numbered in the same order that blocks are laid out within a chunk.
+  */
+  static constexpr blockIndex_t SectionSize() { return param::ChunkSectionSize(); }
+  static constexpr i32 SectionsPerAxis() { return Size() / SectionSize(); }
+  static constexpr i32 TotalSections() { return eng::math::cube(SectionsPerAxis()); }
+  static constexpr u64 AllSections() { return TotalSections() == 64 ? ~u64(0) : eng::u64Bit(TotalSections()) - 1; }
+  static constexpr BlockBox SectionBounds(i32 section)
+  {
+    BlockIndex sectionAnchor = SectionSize() * BlockIndex(section / eng::math::square(SectionsPerAxis()), section / SectionsPerAxis() % SectionsPerAxis(), section % SectionsPerAxis());
+    return BlockBox(sectionAnchor, sectionAnchor + (SectionSize() - 1));
+  }
+  static constexpr i32 SectionOf(const BlockIndex& blockIndex)
+  {
+    return eng::math::square(SectionsPerAxis()) * (blockIndex.i / SectionSize()) + SectionsPerAxis() * (blockIndex.j / SectionSize()) + blockIndex.k / SectionSize();
+  }
+};
+static_assert(Chunk::Size() % Chunk::SectionSize() == 0, "Chunk size must be a multiple of section size!");
+static_assert(Chunk::TotalSections() <= 64, "Chunk sections must fit in a 64-bit mask!");
+static_assert(Chunk::Size() <= 32, "Chunk columns must fit in a 32-bit row mask!");
\ No newline at end of file
@@ -17,14 +17,28 @@ static void fill(BlockArrayBox<T>& arrayBox, const Chunk& chunk, const std::vect
   });
 }
 
+/*
+  Stand-in for chunks that are known to be empty. Its data is never allocated, so it reads as air with full sunlight.
+*/
+static const Chunk& emptyChunk()
+{
+  static const Chunk s_EmptyChunk(GlobalIndex(0));
+  return s_EmptyChunk;
+}
+
 template<typename T>
-static BlockArrayBox<T> retrieveData(const Chunk& chunk, const std::vector<BlockBox>& regions, const eng::thread::UnorderedMap<GlobalIndex, Chunk>& chunkMap)
+static void retrieveData(BlockArrayBox<T>& arrayBox, const GlobalIndex& anchorIndex, const Chunk* anchorChunk, const std::vector<BlockBox>& regions,
+                         const eng::thread::UnorderedMap<GlobalIndex, Chunk>& chunkMap, const eng::thread::UnorderedSet<GlobalIndex>& knownEmptyIndices)
 {
   BlockBox arrayBoxSize = eng::algo::accumulate(regions, eng::Identity<BlockBox>(), [](const BlockBox& boxSize, const BlockBox& box)
   {
     return boxSize.expandToEnclose(box);
   });
-  BlockArrayBox<T> arrayBox(arrayBoxSize, eng::AllocationPolicy::DefaultInitialize);
+
+  // Reuse the existing allocation when possible
+  if (!arrayBox || arrayBox.bounds() != arrayBoxSize)
+    arrayBox = BlockArrayBox<T>(arrayBoxSize, eng::AllocationPolicy::ForOverwrite);
+  arrayBox.fill(arrayBoxSize, T());
 
   std::unordered_map<LocalIndex, std::vector<BlockBox>> partitionedRegions;
   for (const BlockBox& region : regions)
@@ -33,12 +47,14 @@ static BlockArrayBox<T> retrieveData(const Chunk& chunk, const std::vector<Block
 
   for (const auto& [relativeIndex, chunkSections] : partitionedRegions)
   {
-    if (relativeIndex == LocalIndex(0))
-      fill(arrayBox, chunk, chunkSections, relativeIndex);
-    else if (std::shared_ptr<const Chunk> neighbor = chunkMap.get(chunk.globalIndex() + relativeIndex.upcast<globalIndex_t>()))
+    GlobalIndex chunkIndex = anchorIndex + relativeIndex.upcast<globalIndex_t>();
+    if (relativeIndex == LocalIndex(0) && anchorChunk)
+      fill(arrayBox, *anchorChunk, chunkSections, relativeIndex);
+    else if (std::shared_ptr<const Chunk> neighbor = chunkMap.get(chunkIndex))
       fill(arrayBox, *neighbor, chunkSections, relativeIndex);
+    else if (knownEmptyIndices.contains(chunkIndex))
+      fill(arrayBox, emptyChunk(), chunkSections, relativeIndex);
   }
-  return arrayBox;
 }
 
 
@@ -52,12 +68,40 @@ const eng::thread::UnorderedMap<GlobalIndex, Chunk>& ChunkContainer::chunks() co
 
 BlockArrayBox<block::Type> ChunkContainer::retrieveTypeData(const Chunk& chunk, const std::vector<BlockBox>& regions) const
 {
-  return retrieveData<block::Type>(chunk, regions, m_Chunks);
+  BlockArrayBox<block::Type> arrayBox(BlockBox(0, 0), eng::AllocationPolicy::Deferred);
+  retrieveTypeData(arrayBox, chunk, regions);
+  return arrayBox;
 }
 
 BlockArrayBox<block::Light> ChunkContainer::retrieveLightingData(const Chunk& chunk, const std::vector<BlockBox>& regions) const
 {
-  return retrieveData<block::Light>(chunk, regions, m_Chunks);
+  BlockArrayBox<block::Light> arrayBox(BlockBox(0, 0), eng::AllocationPolicy::Deferred);
+  retrieveLightingData(arrayBox, chunk, regions);
+  return arrayBox;
+}
+
+void ChunkContainer::retrieveTypeData(BlockArrayBox<block::Type>& arrayBox, const Chunk& chunk, const std::vector<BlockBox>& regions) const
+{
+  retrieveData<block::Type>(arrayBox, chunk.globalIndex(), &chunk, regions, m_Chunks, m_KnownEmptyIndices);
+}
+
+void ChunkContainer::retrieveLightingData(BlockArrayBox<block::Light>& arrayBox, const Chunk& chunk, const std::vector<BlockBox>& regions) const
+{
+  retrieveData<block::Light>(arrayBox, chunk.globalIndex(), &chunk, regions, m_Chunks, m_KnownEmptyIndices);
+}
+
+BlockArrayBox<block::Type> ChunkContainer::retrieveTypeData(const GlobalIndex& anchorIndex, const std::vector<BlockBox>& regions) const
+{
+  BlockArrayBox<block::Type> arrayBox(BlockBox(0, 0), eng::AllocationPolicy::Deferred);
+  retrieveData<block::Type>(arrayBox, anchorIndex, nullptr, regions, m_Chunks, m_KnownEmptyIndices);
+  return arrayBox;
+}
+
+BlockArrayBox<block::Light> ChunkContainer::retrieveLightingData(const GlobalIndex& anchorIndex, const std::vector<BlockBox>& regions) const
+{
+  BlockArrayBox<block::Light> arrayBox(BlockBox(0, 0), eng::AllocationPolicy::Deferred);
+  retrieveData<block::Light>(arrayBox, anchorIndex, nullptr, regions, m_Chunks, m_KnownEmptyIndices);
+  return arrayBox;
 }
 
 std::unordered_set<GlobalIndex> ChunkContainer::findAllLoadableIndices() const
@@ -73,41 +117,95 @@ std::unordered_set<GlobalIndex> ChunkContainer::findAllLoadableIndices() const
   return newChunkIndices;
 }
 
-bool ChunkContainer::insert(const GlobalIndex& chunkIndex, const std::shared_ptr<Chunk>& newChunk)
+bool ChunkContainer::insert(const GlobalIndex& chunkIndex, const std::shared_ptr<Chunk>& newChunk, std::vector<GlobalIndex>& readyIndices)
 {
   ENG_ASSERT(newChunk, "Chunk does not exist!");
 
+  // Insertion and readiness checks must happen together, otherwise two neighbors loading at the same time could both miss each other
+  std::lock_guard lock(m_InsertionMutex);
+
   bool chunkInserted = m_Chunks.insert(chunkIndex, newChunk);
-  if (chunkInserted)
-    boundaryUpdate(chunkIndex);
+  if (!chunkInserted)
+    return false;
+
+  m_KnownEmptyIndices.erase(chunkIndex);
+  boundaryUpdate(chunkIndex);
+  findSettledNear(chunkIndex, readyIndices);
+  return true;
+}
+
+bool ChunkContainer::insertKnownEmpty(const GlobalIndex& chunkIndex, std::vector<GlobalIndex>& readyIndices)
+{
+  std::lock_guard lock(m_InsertionMutex);
+
+  if (m_Chunks.contains(chunkIndex) || !m_KnownEmptyIndices.insert(chunkIndex))
+    return false;
+
+  boundaryUpdate(chunkIndex);
+  findSettledNear(chunkIndex, readyIndices);
+  return true;
+}
 
-  return chunkInserted;
+bool ChunkContainer::isKnownEmpty(const GlobalIndex& chunkIndex) const
+{
+  return m_KnownEmptyIndices.contains(chunkIndex);
+}
+
+std::unordered_set<GlobalIndex> ChunkContainer::knownEmptyIndices() const
+{
+  return m_KnownEmptyIndices.getCurrentState();
 }
 
 bool ChunkContainer::erase(const GlobalIndex& chunkIndex)
 {
-  bool chunkErased = m_Chunks.erase(chunkIndex);
-  if (chunkErased)
-    boundaryUpdate(chunkIndex);
+  std::lock_guard lock(m_InsertionMutex);
+
+  bool chunkErased = m_KnownEmptyIndices.erase(chunkIndex) || m_Chunks.erase(chunkIndex);
+  if (!chunkErased)
+    return false;
 
-  return chunkErased;
+  boundaryUpdate(chunkIndex);
+  return true;
 }
 
-bool ChunkContainer::hasBoundaryNeighbors(const GlobalIndex& chunkIndex)
+std::vector<GlobalIndex> ChunkContainer::updateSkyExposure(const GlobalIndex& chunkIndex) const
 {
-  return eng::algo::anyOf(Chunk::Stencil(chunkIndex), [this](const GlobalIndex& stencilIndex)
+  std::lock_guard lock(m_SkyExposureMutex);
+
+  std::vector<GlobalIndex> updatedIndices;
+  for (GlobalIndex columnIndex = chunkIndex;; columnIndex += GlobalIndex::Dir(eng::math::Direction::Bottom))
   {
-    return m_BoundaryIndices.contains(stencilIndex);
-  });
-}
+    std::shared_ptr<Chunk> chunk = m_Chunks.get(columnIndex);
+    if (!chunk)
+      break;
 
+    Chunk::ColumnMask skyExposure{};
+    if (std::shared_ptr<Chunk> chunkAbove = m_Chunks.get(columnIndex + GlobalIndex::Dir(eng::math::Direction::Top)))
+    {
+      Chunk::ColumnMask exposureAbove = chunkAbove->skyExposure();
+      Chunk::ColumnMask transparentColumnsAbove = chunkAbove->transparentColumns();
+      for (blockIndex_t i = 0; i < Chunk::Size(); ++i)
+        skyExposure[i] = exposureAbove[i] & transparentColumnsAbove[i];
+    }
+    else
+      skyExposure.fill(~0U);
 
+    if (!chunk->setSkyExposure(skyExposure))
+      break;
+    updatedIndices.push_back(columnIndex);
+  }
+  return updatedIndices;
+}
 
 bool ChunkContainer::isOnBoundary(const GlobalIndex& chunkIndex) const
 {
   return eng::algo::anyOf(eng::math::Directions(), [this, &chunkIndex](eng::math::Direction direction)
   {
-    std::shared_ptr<Chunk> cardinalNeighbor = m_Chunks.get(chunkIndex + GlobalIndex::Dir(direction));
+    GlobalIndex neighborIndex = chunkIndex + GlobalIndex::Dir(direction);
+    if (m_KnownEmptyIndices.contains(neighborIndex))
+      return true;
+
+    std::shared_ptr<Chunk> cardinalNeighbor = m_Chunks.get(neighborIndex);
     return cardinalNeighbor && !cardinalNeighbor->isFaceOpaque(!direction);
   });
 }
@@ -116,9 +214,37 @@ void ChunkContainer::boundaryUpdate(const GlobalIndex& chunkIndex)
 {
   for (const GlobalIndex& neighborIndex : Chunk::Stencil(chunkIndex))
   {
-    if (m_Chunks.contains(neighborIndex) || !isOnBoundary(neighborIndex))
+    if (m_Chunks.contains(neighborIndex) || m_KnownEmptyIndices.contains(neighborIndex) || !isOnBoundary(neighborIndex))
       m_BoundaryIndices.erase(neighborIndex);
     else
       m_BoundaryIndices.insert(neighborIndex);
   }
+}
+
+bool ChunkContainer::isSettled(const GlobalIndex& chunkIndex, const Chunk& chunk) const
+{
+  auto isSealedOff = [&chunkIndex, &chunk](const GlobalIndex& neighborIndex)
+  {
+    return eng::algo::anyOf(eng::math::Directions(), [&chunkIndex, &chunk, &neighborIndex](eng::math::Direction direction)
+    {
+      return neighborIndex == chunkIndex + GlobalIndex::Dir(direction) && chunk.isFaceOpaque(direction);
+    });
+  };
+
+  return eng::algo::allOf(Chunk::Stencil(chunkIndex), [this, &isSealedOff](const GlobalIndex& neighborIndex)
+  {
+    if (m_Chunks.contains(neighborIndex) || m_KnownEmptyIndices.contains(neighborIndex))
+      return true;
+    return !m_BoundaryIndices.contains(neighborIndex) || isSealedOff(neighborIndex);
+  });
+}
+
+void ChunkContainer::findSettledNear(const GlobalIndex& chunkIndex, std::vector<GlobalIndex>& readyIndices) const
+{
+  for (const GlobalIndex& nearbyIndex : Chunk::Stencil(chunkIndex).expand())
+  {
+    std::shared_ptr<Chunk> chunk = m_Chunks.get(nearbyIndex);
+    if (chunk && chunk->state() == Chunk::State::Generated && isSettled(nearbyIndex, *chunk))
+      readyIndices.push_back(nearbyIndex);
+  }
 }
\ No newline at end of file
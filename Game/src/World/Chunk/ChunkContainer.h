@@ -9,6 +9,9 @@ class ChunkContainer
 {
   eng::thread::UnorderedMap<GlobalIndex, Chunk> m_Chunks;
   eng::thread::UnorderedSet<GlobalIndex> m_BoundaryIndices;
+  eng::thread::UnorderedSet<GlobalIndex> m_KnownEmptyIndices;
+  std::mutex m_InsertionMutex;
+  mutable std::mutex m_SkyExposureMutex;
 
 public:
   ChunkContainer();
@@ -18,6 +21,20 @@ public:
   BlockArrayBox<block::Type> retrieveTypeData(const Chunk& chunk, const std::vector<BlockBox>& regions) const;
   BlockArrayBox<block::Light> retrieveLightingData(const Chunk& chunk, const std::vector<BlockBox>& regions) const;
 
+  /*
+    Overloads that write into an existing array box, so that callers can reuse scratch buffers.
+    The array box is only reallocated if its bounds do not match the bounds enclosing the given regions.
+  */
+  void retrieveTypeData(BlockArrayBox<block::Type>& arrayBox, const Chunk& chunk, const std::vector<BlockBox>& regions) const;
+  void retrieveLightingData(BlockArrayBox<block::Light>& arrayBox, const Chunk& chunk, const std::vector<BlockBox>& regions) const;
+
+  /*
+    Overloads for regions that span several chunks. Regions are given relative to the chunk at the anchor index,
+    which does not need to be loaded. Chunks that are not loaded are treated as empty.
+  */
+  BlockArrayBox<block::Type> retrieveTypeData(const GlobalIndex& anchorIndex, const std::vector<BlockBox>& regions) const;
+  BlockArrayBox<block::Light> retrieveLightingData(const GlobalIndex& anchorIndex, const std::vector<BlockBox>& regions) const;
+
   /*
     Scans boundary for places where new chunks can be loaded.
 
@@ -27,21 +44,43 @@ public:
 
   /*
     Inserts chunk and adds it to boundary map. Its neighbors are moved from boundary map
-    if they are no longer on the boundary.
+    if they are no longer on the boundary. Any generated chunk that became settled as a
+    result of the insertion is appended to readyIndices.
 
     \returns True if the chunk was successfully inserted into the boundary map.
   */
-  bool insert(const GlobalIndex& chunkIndex, const std::shared_ptr<Chunk>& newChunk);
+  bool insert(const GlobalIndex& chunkIndex, const std::shared_ptr<Chunk>& newChunk, std::vector<GlobalIndex>& readyIndices);
+
+  /*
+    Marks a chunk as known to be empty, without generating it. Known empty chunks are treated as loaded chunks
+    of air for the purposes of boundary expansion and data retrieval, but take up no memory beyond their index.
+    They are replaced by a real chunk if one is inserted at the same index.
+    Generated chunks that became settled as a result are appended to readyIndices.
+
+    \returns True if the chunk was not already loaded or known to be empty.
+  */
+  bool insertKnownEmpty(const GlobalIndex& chunkIndex, std::vector<GlobalIndex>& readyIndices);
+  bool isKnownEmpty(const GlobalIndex& chunkIndex) const;
+  std::unordered_set<GlobalIndex> knownEmptyIndices() const;
 
   /*
     Removes chunk from boundary map, unloads it, and frees the slot it was occupying.
     The cardinal neighbors of the removed chunk are re-categorized as boundary chunks.
+    Also removes known empty chunks.
 
     \returns True if the chunk existed, was a boundary chunk, and was successfully removed.
   */
   bool erase(const GlobalIndex& chunkIndex);
 
-  bool hasBoundaryNeighbors(const GlobalIndex& chunkIndex);
+  /*
+    Recomputes the sky exposure of the given chunk from the chunk above it. A column is exposed to the sky if the
+    chunk above is not loaded, or if the column above is both exposed and free of opaque blocks. The update continues
+    downward for as long as the exposure of the next chunk changes. Updates are serialized, so that an update
+    computed from stale exposure above can never overwrite a newer one.
+
+    \returns Chunks whose sky exposure changed.
+  */
+  std::vector<GlobalIndex> updateSkyExposure(const GlobalIndex& chunkIndex) const;
 
 private:
   /*
@@ -51,4 +90,19 @@ private:
   bool isOnBoundary(const GlobalIndex& chunkIndex) const;
 
   void boundaryUpdate(const GlobalIndex& chunkIndex);
+
+  /*
+    A chunk is settled once none of its missing stencil neighbors can affect it. A missing neighbor cannot affect
+    the chunk if it is not on the boundary, since no loaded chunk can see into it, or if it is a cardinal neighbor
+    behind an opaque face of the chunk. Neighbors that do load later on only require the chunk to be re-meshed.
+
+    \returns True if the given chunk is settled.
+  */
+  bool isSettled(const GlobalIndex& chunkIndex, const Chunk& chunk) const;
+
+  /*
+    Inserting or removing a chunk changes the boundary status of its stencil neighbors, which in turn
+    can settle any chunk whose stencil contains them. Those chunks are re-checked here.
+  */
+  void findSettledNear(const GlobalIndex& chunkIndex, std::vector<GlobalIndex>& readyIndices) const;
 };
\ No newline at end of file
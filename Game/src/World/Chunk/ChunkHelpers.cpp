@@ -3,16 +3,36 @@
 #include "Chunk.h"
 #include "Indexing/Operations.h"
 
+// Face record packing must round-trip every field
+static constexpr ChunkFaceRecord c_TestFaceRecord(BlockIndex(31, 0, 17), eng::math::Direction::North, block::TextureID::ErrorTexture, BlockIndex2D(32, 5),
+                                                  { 15, 0, 7, 1 }, { 3, 0, 2, 1 }, true);
+static_assert(c_TestFaceRecord.blockIndex() == BlockIndex(31, 0, 17));
+static_assert(c_TestFaceRecord.face() == eng::math::Direction::North);
+static_assert(c_TestFaceRecord.texture() == block::TextureID::ErrorTexture);
+static_assert(c_TestFaceRecord.quadExtents() == BlockIndex2D(32, 5));
+static_assert(c_TestFaceRecord.reversedSeam());
+static_assert(c_TestFaceRecord.light(0) == 15 && c_TestFaceRecord.light(1) == 0 && c_TestFaceRecord.light(2) == 7 && c_TestFaceRecord.light(3) == 1);
+static_assert(c_TestFaceRecord.ambientOcclusion(0) == 3 && c_TestFaceRecord.ambientOcclusion(1) == 0 && c_TestFaceRecord.ambientOcclusion(2) == 2 && c_TestFaceRecord.ambientOcclusion(3) == 1);
+static_assert(sizeof(ChunkFaceRecord) == sizeof(ChunkVertex), "Face records must share the stride of the chunk vertex buffer layout!");
+static_assert(eng::enumCount<block::TextureID>() <= 256, "Face records only have room for 8-bit texture IDs!");
+
+
+
 ChunkVertex::ChunkVertex()
   : m_VertexData(0), m_LightingData(0) {}
-ChunkVertex::ChunkVertex(const BlockIndex& vertexPlacement, i32 quadIndex, block::TextureID texture, i32 sunlight, i32 ambientOcclusion)
+ChunkVertex::ChunkVertex(const BlockIndex& vertexPlacement, i32 quadIndex, const BlockIndex2D& quadExtents, block::TextureID texture, i32 sunlight, i32 blockLight, i32 ambientOcclusion)
 {
+  ENG_ASSERT(eng::withinBounds(quadExtents.i, 1, Chunk::Size() + 1) && eng::withinBounds(quadExtents.j, 1, Chunk::Size() + 1), "Invalid quad extents!");
+
   m_VertexData =  vertexPlacement.i + (vertexPlacement.j << 6) + (vertexPlacement.k << 12);
   m_VertexData |= quadIndex << 18;
   m_VertexData |= std::underlying_type_t<block::TextureID>(texture) << 20;
 
-  m_LightingData =  sunlight << 16;
+  m_LightingData =  quadExtents.i - 1;
+  m_LightingData |= (quadExtents.j - 1) << 5;
+  m_LightingData |= sunlight << 16;
   m_LightingData |= ambientOcclusion << 20;
+  m_LightingData |= blockLight << 24;
 }
 
 const BlockIndex& ChunkVertex::GetOffset(eng::math::Direction face, i32 quadIndex)
@@ -28,40 +48,77 @@ const BlockIndex& ChunkVertex::GetOffset(eng::math::Direction face, i32 quadInde
   return offsets[face][quadIndex];
 }
 
+const std::array<eng::math::Axis, 2>& ChunkVertex::GetQuadAxes(eng::math::Direction face)
+{
+  static constexpr eng::EnumArray<std::array<eng::math::Axis, 2>, eng::math::Direction> quadAxes =
+  { { eng::math::Direction::West,   { eng::math::Axis::Y, eng::math::Axis::Z } },
+    { eng::math::Direction::East,   { eng::math::Axis::Y, eng::math::Axis::Z } },
+    { eng::math::Direction::South,  { eng::math::Axis::X, eng::math::Axis::Z } },
+    { eng::math::Direction::North,  { eng::math::Axis::X, eng::math::Axis::Z } },
+    { eng::math::Direction::Bottom, { eng::math::Axis::X, eng::math::Axis::Y } },
+    { eng::math::Direction::Top,    { eng::math::Axis::X, eng::math::Axis::Y } } };
+
+  return quadAxes[face];
+}
+
+
 
+ChunkVoxel::ChunkVoxel(const BlockIndex& localIndex, eng::EnumBitMask<eng::math::Direction> enabledFaces, i32 ordinal)
+  : m_Data(0)
+{
+  ENG_ASSERT(eng::withinBounds(ordinal, 0, eng::math::cube(Chunk::SectionSize())), "Voxel ordinal is out of range!");
 
-ChunkVoxel::ChunkVoxel(const BlockIndex& blockIndex, eng::EnumBitMask<eng::math::Direction> enabledFaces, i32 firstVertex)
-  : m_Index(blockIndex),
-    m_EnabledFaces(enabledFaces),
-    m_BaseVertex(firstVertex) {}
+  m_Data |= static_cast<u32>(localIndex.i) << 2 * c_CoordinateBits | static_cast<u32>(localIndex.j) << c_CoordinateBits | static_cast<u32>(localIndex.k);
+  for (eng::math::Direction face : eng::math::Directions())
+    if (enabledFaces[face])
+      m_Data |= eng::u32Bit(c_FaceBitsOffset + eng::enumIndex(face));
+  m_Data |= static_cast<u32>(ordinal) << c_OrdinalOffset;
+}
 
-const BlockIndex& ChunkVoxel::index() const
+BlockIndex ChunkVoxel::localIndex() const
 {
-  return m_Index;
+  static constexpr u32 coordinateMask = eng::u32Bit(c_CoordinateBits) - 1;
+  auto unpackCoordinate = [this](i32 offset) { return eng::arithmeticCastUnchecked<blockIndex_t>(m_Data >> offset & coordinateMask); };
+  return BlockIndex(unpackCoordinate(2 * c_CoordinateBits), unpackCoordinate(c_CoordinateBits), unpackCoordinate(0));
 }
 
 bool ChunkVoxel::faceEnabled(eng::math::Direction direction) const
 {
-  return m_EnabledFaces[direction];
+  return m_Data & eng::u32Bit(c_FaceBitsOffset + eng::enumIndex(direction));
+}
+
+i32 ChunkVoxel::faceCount() const
+{
+  return std::popcount(m_Data >> c_FaceBitsOffset & 0x3F);
+}
+
+i32 ChunkVoxel::faceCount(eng::math::Direction before) const
+{
+  return std::popcount(m_Data >> c_FaceBitsOffset & (eng::u32Bit(eng::enumIndex(before)) - 1));
 }
 
-i32 ChunkVoxel::baseVertex() const
+i32 ChunkVoxel::ordinal() const
 {
-  return m_BaseVertex;
+  return eng::arithmeticCastUnchecked<i32>(m_Data >> c_OrdinalOffset);
 }
 
 
 
-ChunkDrawCommand::ChunkDrawCommand(const GlobalIndex& chunkIndex, bool needsSorting)
-  : eng::IndexedDrawCommand<ChunkDrawCommand, GlobalIndex>(chunkIndex),
+ChunkDrawCommand::ChunkDrawCommand(const ChunkSectionID& sectionID, bool needsSorting)
+  : eng::GenericDrawCommand<ChunkDrawCommand, ChunkSectionID, !param::FaceRecordMeshes()>(sectionID),
     m_SortState(-1, -1, -1),
-    m_NeedsSorting(needsSorting),
-    m_VoxelBaseVertex(0) {}
+    m_NeedsSorting(needsSorting) {}
 
 bool ChunkDrawCommand::operator==(const ChunkDrawCommand& other) const { return id() == other.id(); }
 
 eng::mem::IndexData ChunkDrawCommand::indexData() const { return m_Indices; }
-eng::mem::RenderData ChunkDrawCommand::vertexData() const { return m_Vertices; }
+eng::mem::RenderData ChunkDrawCommand::vertexData() const
+{
+  if constexpr (param::FaceRecordMeshes())
+    return m_SortedFaceRecords.empty() ? m_FaceRecords : m_SortedFaceRecords;
+  else
+    return m_Vertices;
+}
 
 void ChunkDrawCommand::clearData()
 {
@@ -70,58 +127,129 @@ void ChunkDrawCommand::clearData()
   {
     m_Voxels = {};
     m_Indices = {};
+    m_FaceRecords = {};
+    m_SortedFaceRecords = {};
   }
 }
 
-void ChunkDrawCommand::addQuad(const BlockIndex& blockIndex, eng::math::Direction face, block::TextureID texture, const std::array<i32, 4>& sunlight, const std::array<i32, 4>& ambientOcclusion)
+void ChunkDrawCommand::addQuad(const BlockIndex& blockIndex, eng::math::Direction face, block::TextureID texture,
+                               const std::array<i32, 4>& sunlight, const std::array<i32, 4>& blockLight, const std::array<i32, 4>& ambientOcclusion)
+{
+  addQuad(blockIndex, BlockIndex2D(1), face, texture, sunlight, blockLight, ambientOcclusion);
+}
+
+void ChunkDrawCommand::addQuad(const BlockIndex& blockIndex, const BlockIndex2D& quadExtents, eng::math::Direction face, block::TextureID texture,
+                               const std::array<i32, 4>& sunlight, const std::array<i32, 4>& blockLight, const std::array<i32, 4>& ambientOcclusion)
 {
   static constexpr std::array<i32, 4> standardOrder = { 0, 1, 2, 3 };
   static constexpr std::array<i32, 4> reversedOrder = { 1, 3, 0, 2 };
-  auto totalLightAtVertex = [&sunlight, &ambientOcclusion](i32 index) { return sunlight[index] + ambientOcclusion[index]; };
+
+  std::array<i32, 4> vertexLight{};
+  for (i32 quadIndex = 0; quadIndex < 4; ++quadIndex)
+    vertexLight[quadIndex] = std::max(sunlight[quadIndex], blockLight[quadIndex]);
+  auto totalLightAtVertex = [&vertexLight, &ambientOcclusion](i32 index) { return vertexLight[index] + ambientOcclusion[index]; };
 
   i32 lightDifferenceAlongStandardSeam = std::abs(totalLightAtVertex(2) - totalLightAtVertex(1));
   i32 lightDifferenceAlongReversedSeam = std::abs(totalLightAtVertex(3) - totalLightAtVertex(0));
-  const std::array<i32, 4>& quadOrder = lightDifferenceAlongStandardSeam > lightDifferenceAlongReversedSeam ? reversedOrder : standardOrder;
+  bool useReversedSeam = lightDifferenceAlongStandardSeam > lightDifferenceAlongReversedSeam;
+  if constexpr (param::FaceRecordMeshes())
+  {
+    m_FaceRecords.emplace_back(blockIndex, face, texture, quadExtents, vertexLight, ambientOcclusion, useReversedSeam);
+    return;
+  }
+
+  const std::array<i32, 4>& quadOrder = useReversedSeam ? reversedOrder : standardOrder;
+  const std::array<eng::math::Axis, 2>& quadAxes = ChunkVertex::GetQuadAxes(face);
   for (i32 i = 0; i < 4; ++i)
   {
     i32 quadIndex = quadOrder[i];
-    BlockIndex vertexPlacement = blockIndex + ChunkVertex::GetOffset(face, quadIndex);
-    m_Vertices.emplace_back(vertexPlacement, quadIndex, texture, sunlight[quadIndex], ambientOcclusion[quadIndex]);
+
+    // Stretch vertex offset along the quad axes to cover the full quad
+    BlockIndex vertexOffset = ChunkVertex::GetOffset(face, quadIndex);
+    vertexOffset[quadAxes[0]] *= quadExtents.i;
+    vertexOffset[quadAxes[1]] *= quadExtents.j;
+
+    m_Vertices.emplace_back(blockIndex + vertexOffset, quadIndex, quadExtents, texture, sunlight[quadIndex], blockLight[quadIndex], ambientOcclusion[quadIndex]);
   }
-  addQuadIndices(eng::arithmeticCast<i32>(m_Vertices.size() - 4));
+  // Meshes that are never sorted draw from a shared quad index buffer
+  if (m_NeedsSorting || !param::SharedQuadIndices())
+    addQuadIndices(eng::arithmeticCast<i32>(m_Vertices.size() - 4));
 }
 
 void ChunkDrawCommand::addVoxel(const BlockIndex& blockIndex, eng::EnumBitMask<eng::math::Direction> enabledFaces)
 {
-  m_Voxels.emplace_back(blockIndex, enabledFaces, m_VoxelBaseVertex);
-  m_VoxelBaseVertex = eng::arithmeticCast<i32>(m_Vertices.size());
+  // Voxels are only needed for sorting
+  if (!m_NeedsSorting)
+    return;
+
+  if (m_Voxels.empty())
+    m_VoxelBounds = BlockBox(blockIndex, blockIndex);
+  else
+    m_VoxelBounds.expandToEnclose(blockIndex);
+
+  BlockIndex sectionAnchor = Chunk::SectionBounds(id().section).min;
+  m_Voxels.emplace_back(blockIndex - sectionAnchor, enabledFaces, eng::arithmeticCast<i32>(m_Voxels.size()));
+}
+
+template<typename T>
+static void borrowBuffer(std::vector<T>& buffer, std::vector<T>& scratchBuffer)
+{
+  ENG_ASSERT(buffer.empty(), "Mesh data has already been added!");
+  scratchBuffer.clear();
+  buffer.swap(scratchBuffer);
+}
+
+template<typename T>
+static void returnBuffer(std::vector<T>& buffer, std::vector<T>& scratchBuffer)
+{
+  scratchBuffer = std::exchange(buffer, std::vector<T>(buffer.begin(), buffer.end()));
+}
+
+void ChunkDrawCommand::borrowBuffers(ChunkMeshBuffers& buffers)
+{
+  borrowBuffer(m_Vertices, buffers.vertices);
+  borrowBuffer(m_FaceRecords, buffers.faceRecords);
+  borrowBuffer(m_Voxels, buffers.voxels);
+  borrowBuffer(m_Indices, buffers.indices);
+}
+
+void ChunkDrawCommand::returnBuffers(ChunkMeshBuffers& buffers)
+{
+  returnBuffer(m_Vertices, buffers.vertices);
+  returnBuffer(m_FaceRecords, buffers.faceRecords);
+  returnBuffer(m_Voxels, buffers.voxels);
+  returnBuffer(m_Indices, buffers.indices);
 }
 
 bool ChunkDrawCommand::sort(const GlobalIndex& originIndex, const eng::math::Vec3& viewPosition)
 {
   using keyType = std::make_unsigned_t<blockIndex_t>;
-  static constexpr keyType c_MaxL1Distance = 3 * (Chunk::Size() - 1);
+  static constexpr keyType c_MaxL1Distance = 3 * (Chunk::SectionSize() - 1);
+
+  if (m_Voxels.empty())
+    return false;
 
-  // Find block index that is closest to the specified position
-  BlockIndex originBlock = BlockIndex::ToIndex(viewPosition / block::length());
-  ENG_ASSERT(Chunk::Bounds().encloses(originBlock), "Given view position is not inside the origin chunk!");
+  // Find block index within the bounds of the voxels that is closest to the specified position.
+  // Moving along an axis outside of these bounds does not change the L1 ordering of the voxels.
+  eng::math::Vec3 relativeViewPosition = (viewPosition - indexPosition(id().chunkIndex, originIndex)) / block::length();
+  BlockIndex originBlock;
   for (eng::math::Axis axis : eng::math::Axes())
   {
-    if (originIndex[axis] > id()[axis])
-      originBlock[axis] = Chunk::Size() - 1;
-    else if (originIndex[axis] < id()[axis])
-      originBlock[axis] = 0;
+    length_t blockCoordinate = std::floor(relativeViewPosition[eng::enumIndex(axis)]);
+    originBlock[axis] = eng::arithmeticCastUnchecked<blockIndex_t>(std::clamp<length_t>(blockCoordinate, m_VoxelBounds.min[axis], m_VoxelBounds.max[axis]));
   }
 
   // If this block index is the same as the previous sort, no need to sort
   if (originBlock == m_SortState)
     return false;
+  m_SortState = originBlock;
 
   // Perform an in-place counting sort on L1 distance to originBlock, from highest to lowest
+  BlockIndex localOriginBlock = originBlock - Chunk::SectionBounds(id().section).min;
   std::array<i16, c_MaxL1Distance + 1> counts{};
   for (ChunkVoxel voxel : m_Voxels)
   {
-    keyType key = c_MaxL1Distance - (voxel.index() - originBlock).l1Norm();
+    keyType key = c_MaxL1Distance - (voxel.localIndex() - localOriginBlock).l1Norm();
     counts[key]++;
   }
   eng::algo::partialSum(counts, counts.begin());
@@ -129,7 +257,7 @@ bool ChunkDrawCommand::sort(const GlobalIndex& originIndex, const eng::math::Vec
   std::array<i16, c_MaxL1Distance + 1> placements = counts;
   for (uSize i = 0; i < m_Voxels.size();)
   {
-    keyType key = c_MaxL1Distance - (m_Voxels[i].index() - originBlock).l1Norm();
+    keyType key = c_MaxL1Distance - (m_Voxels[i].localIndex() - localOriginBlock).l1Norm();
     keyType prevCount = key > 0 ? counts[key - 1] : 0;
 
     if (prevCount <= i && i < counts[key])
@@ -141,11 +269,7 @@ bool ChunkDrawCommand::sort(const GlobalIndex& originIndex, const eng::math::Vec
     }
   }
 
-  // Update sort state and indices
-  m_SortState = originBlock;
-  reorderIndices(originIndex, viewPosition);
-
-  return true;
+  return reorderQuads(originIndex, viewPosition);
 }
 
 void ChunkDrawCommand::addQuadIndices(i32 baseVertex)
@@ -159,39 +283,72 @@ void ChunkDrawCommand::addQuadIndices(i32 baseVertex)
   m_Indices.push_back(baseVertex + 2);
 }
 
-void ChunkDrawCommand::reorderIndices(const GlobalIndex& originIndex, const eng::math::Vec3& viewPosition)
+bool ChunkDrawCommand::reorderQuads(const GlobalIndex& originIndex, const eng::math::Vec3& viewPosition)
 {
-  m_Indices.clear();
+  static constexpr i32 c_QuadSize = param::FaceRecordMeshes() ? 1 : 4;
+
+  // New quad orders are built in scratch memory so that unchanged orders are not re-uploaded
+  static thread_local std::vector<u32> tl_SortedIndices;
+  static thread_local std::vector<ChunkFaceRecord> tl_SortedFaceRecords;
+  tl_SortedIndices.clear();
+  tl_SortedFaceRecords.clear();
+  auto emitQuad = [this](i32 quadStart)
+  {
+    if constexpr (param::FaceRecordMeshes())
+      tl_SortedFaceRecords.push_back(m_FaceRecords[quadStart]);
+    else
+      for (i32 quadIndex : { 0, 1, 2, 1, 3, 2 })
+        tl_SortedIndices.push_back(quadStart + quadIndex);
+  };
 
-  eng::math::Vec3 chunkAnchorPosition = indexPosition(id(), originIndex);
+  // Recover where the quads of each voxel begin from the number of faces of the voxels added before it
+  std::array<u16, eng::math::cube(Chunk::SectionSize())> firstQuads;
   for (ChunkVoxel voxel : m_Voxels)
+    firstQuads[voxel.ordinal()] = eng::arithmeticCastUnchecked<u16>(voxel.faceCount());
+  u16 quadCount = 0;
+  for (uSize ordinal = 0; ordinal < m_Voxels.size(); ++ordinal)
   {
-    eng::math::Vec3 blockCenter = chunkAnchorPosition + block::length() * eng::math::Vec3(voxel.index()) + eng::math::Vec3(block::length()) / 2;
-    eng::math::Vec3 toBlock = blockCenter - viewPosition;
+    u16 voxelQuadCount = firstQuads[ordinal];
+    firstQuads[ordinal] = quadCount;
+    quadCount += voxelQuadCount;
+  }
 
-    i32 quadVertexOffset = 0;
-    eng::EnumArray<i32, eng::math::Direction> quadVertexOffsets(-1);
-    for (eng::math::Direction face : eng::math::Directions())
-      if (voxel.faceEnabled(face))
-      {
-        quadVertexOffsets[face] = quadVertexOffset;
-        quadVertexOffset += 4;
-      }
+  BlockIndex sectionAnchor = Chunk::SectionBounds(id().section).min;
+  eng::math::Vec3 sectionAnchorPosition = indexPosition(id().chunkIndex, originIndex) + block::length() * eng::math::Vec3(sectionAnchor);
+  for (ChunkVoxel voxel : m_Voxels)
+  {
+    eng::math::Vec3 blockCenter = sectionAnchorPosition + block::length() * eng::math::Vec3(voxel.localIndex()) + eng::math::Vec3(block::length()) / 2;
+    eng::math::Vec3 toBlock = blockCenter - viewPosition;
+    i32 firstQuad = firstQuads[voxel.ordinal()];
 
     // Add back-facing quads
     for (eng::math::Axis axis : eng::math::Axes())
     {
       eng::math::Direction face = toDirection(axis, toBlock[eng::enumIndex(axis)] > 0);
-      if (quadVertexOffsets[face] >= 0)
-        addQuadIndices(voxel.baseVertex() + quadVertexOffsets[face]);
+      if (voxel.faceEnabled(face))
+        emitQuad(c_QuadSize * (firstQuad + voxel.faceCount(face)));
     }
 
     // Add front-facing quads
     for (eng::math::Axis axis : eng::math::Axes())
     {
       eng::math::Direction face = toDirection(axis, toBlock[eng::enumIndex(axis)] <= 0);
-      if (quadVertexOffsets[face] >= 0)
-        addQuadIndices(voxel.baseVertex() + quadVertexOffsets[face]);
+      if (voxel.faceEnabled(face))
+        emitQuad(c_QuadSize * (firstQuad + voxel.faceCount(face)));
     }
   }
+
+  if constexpr (param::FaceRecordMeshes())
+  {
+    if (tl_SortedFaceRecords == m_SortedFaceRecords)
+      return false;
+    m_SortedFaceRecords.swap(tl_SortedFaceRecords);
+  }
+  else
+  {
+    if (tl_SortedIndices == m_Indices)
+      return false;
+    m_Indices.swap(tl_SortedIndices);
+  }
+  return true;
 }
\ No newline at end of file
@@ -12,8 +12,14 @@
     bits 20-31: Texure ID
 
   Lighting Data:
+    bits 0-4:   Quad width minus one, in blocks
+    bits 5-9:   Quad height minus one, in blocks
     bits 16-19: Sunlight intensity
     bits 20-22: Ambient occlusion level
+    bits 24-27: Block light intensity
+
+  Quads larger than a single block face are produced by greedy meshing.
+  Their texture is repeated once per block along both quad axes.
 */
 class ChunkVertex
 {
@@ -22,41 +28,163 @@ class ChunkVertex
 
 public:
   ChunkVertex();
-  ChunkVertex(const BlockIndex& vertexPlacement, i32 quadIndex, block::TextureID texture, i32 sunlight, i32 ambientOcclusion);
+  ChunkVertex(const BlockIndex& vertexPlacement, i32 quadIndex, const BlockIndex2D& quadExtents, block::TextureID texture, i32 sunlight, i32 blockLight, i32 ambientOcclusion);
 
   static const BlockIndex& GetOffset(eng::math::Direction face, i32 quadIndex);
+
+  /*
+    \returns The axes along which the u and v texture coordinates of a quad on the given face increase.
+  */
+  static const std::array<eng::math::Axis, 2>& GetQuadAxes(eng::math::Direction face);
+};
+
+/*
+  Represents a single quad in a compressed format, expanded into vertices in the shader by
+  vertex pulling. Used in place of ChunkVertex when param::FaceRecordMeshes() is enabled.
+  Fields are laid out so that none straddle the 32-bit boundary, as shaders read records as uvec2.
+
+    bits 0-14:  Block index of the quad's minimum corner (3-comps, 5 bits each)
+    bits 15-17: Face direction
+    bits 18-25: Texture ID
+    bits 26-30: Quad width minus one, in blocks
+    bit  31:    Whether the quad is triangulated along its reversed seam
+    bits 32-36: Quad height minus one, in blocks
+    bits 37-52: Light intensity at each quad vertex (4 bits each)
+    bits 53-60: Ambient occlusion level at each quad vertex (2 bits each)
+
+  There is no room for a separate block light channel, so the light of each vertex is the brighter of its
+  sunlight and block light. Block light in this format is therefore scaled by sun intensity in the shader.
+*/
+class ChunkFaceRecord
+{
+  u64 m_Data;
+
+public:
+  constexpr ChunkFaceRecord()
+    : m_Data(0) {}
+  constexpr ChunkFaceRecord(const BlockIndex& blockIndex, eng::math::Direction face, block::TextureID texture, const BlockIndex2D& quadExtents,
+                            const std::array<i32, 4>& light, const std::array<i32, 4>& ambientOcclusion, bool reversedSeam)
+    : m_Data(0)
+  {
+    m_Data |= pack(blockIndex.i, 0, 5) | pack(blockIndex.j, 5, 5) | pack(blockIndex.k, 10, 5);
+    m_Data |= pack(eng::enumIndex(face), 15, 3);
+    m_Data |= pack(eng::toUnderlying(texture), 18, 8);
+    m_Data |= pack(quadExtents.i - 1, 26, 5);
+    m_Data |= pack(reversedSeam, 31, 1);
+    m_Data |= pack(quadExtents.j - 1, 32, 5);
+    for (i32 quadIndex = 0; quadIndex < 4; ++quadIndex)
+    {
+      m_Data |= pack(light[quadIndex], 37 + 4 * quadIndex, 4);
+      m_Data |= pack(ambientOcclusion[quadIndex], 53 + 2 * quadIndex, 2);
+    }
+  }
+
+  constexpr bool operator==(const ChunkFaceRecord& other) const = default;
+
+  constexpr BlockIndex blockIndex() const { return BlockIndex(unpack<blockIndex_t>(0, 5), unpack<blockIndex_t>(5, 5), unpack<blockIndex_t>(10, 5)); }
+  constexpr eng::math::Direction face() const { return eng::enumCastUnchecked<eng::math::Direction>(unpack<i32>(15, 3)); }
+  constexpr block::TextureID texture() const { return eng::enumCastUnchecked<block::TextureID>(unpack<i32>(18, 8)); }
+  constexpr BlockIndex2D quadExtents() const { return BlockIndex2D(unpack<blockIndex_t>(26, 5) + 1, unpack<blockIndex_t>(32, 5) + 1); }
+  constexpr bool reversedSeam() const { return unpack<i32>(31, 1); }
+  constexpr i32 light(i32 quadIndex) const { return unpack<i32>(37 + 4 * quadIndex, 4); }
+  constexpr i32 ambientOcclusion(i32 quadIndex) const { return unpack<i32>(53 + 2 * quadIndex, 2); }
+
+  static constexpr u32 VerticesPerFace() { return 6; }
+
+private:
+  template<std::integral T>
+  static constexpr u64 pack(T value, i32 offset, i32 bits) { return (static_cast<u64>(value) & (eng::u64Bit(bits) - 1)) << offset; }
+
+  template<std::integral T>
+  constexpr T unpack(i32 offset, i32 bits) const { return static_cast<T>(m_Data >> offset & (eng::u64Bit(bits) - 1)); }
 };
 
 /*
   Represents the renderable portions of a voxel. Stores as little information as
   possible, as these need to be sorted quickly at runtime.
+  Compressed format is as follows,
+    bits 0-11:  Block index relative to the section anchor (3-comps, 4 bits each)
+    bits 12-17: Enabled faces (1 bit per direction)
+    bits 18-29: Order in which the voxel was added to its draw command
+  Quads of a voxel are stored contiguously in the order that voxels were added, so the location
+  of a voxel's quads can be recovered from the faces of the voxels that were added before it.
 */
 class ChunkVoxel
 {
-  BlockIndex m_Index;
-  eng::EnumBitMask<eng::math::Direction> m_EnabledFaces;
-  i32 m_BaseVertex;
+  static constexpr i32 c_CoordinateBits = std::bit_width(static_cast<u32>(param::ChunkSectionSize() - 1));
+  static constexpr i32 c_FaceBitsOffset = 3 * c_CoordinateBits;
+  static constexpr i32 c_OrdinalOffset = c_FaceBitsOffset + 6;
+  static_assert(c_OrdinalOffset + 3 * c_CoordinateBits <= 32, "Chunk sections are too large for voxels to be packed into 32 bits!");
+
+  u32 m_Data;
 
 public:
-  ChunkVoxel(const BlockIndex& blockIndex, eng::EnumBitMask<eng::math::Direction> enabledFaces, i32 firstVertex);
+  ChunkVoxel(const BlockIndex& localIndex, eng::EnumBitMask<eng::math::Direction> enabledFaces, i32 ordinal);
 
-  const BlockIndex& index() const;
+  BlockIndex localIndex() const;
   bool faceEnabled(eng::math::Direction direction) const;
-  i32 baseVertex() const;
+
+  /*
+    \returns The number of enabled faces, or the number of enabled faces preceding the given face.
+  */
+  i32 faceCount() const;
+  i32 faceCount(eng::math::Direction before) const;
+
+  i32 ordinal() const;
 };
 
-class ChunkDrawCommand : public eng::IndexedDrawCommand<ChunkDrawCommand, GlobalIndex>
+/*
+  Identifies the draw command of a single chunk section.
+*/
+struct ChunkSectionID
+{
+  GlobalIndex chunkIndex;
+  i32 section;
+
+  bool operator==(const ChunkSectionID& other) const = default;
+};
+
+namespace std
+{
+  template<>
+  struct hash<ChunkSectionID>
+  {
+    uSize operator()(const ChunkSectionID& sectionID) const
+    {
+      return std::hash<GlobalIndex>()(sectionID.chunkIndex) ^ std::hash<i32>()(sectionID.section) << 1;
+    }
+  };
+}
+
+/*
+  Reusable storage for building chunk meshes. Meshing tasks keep one set per worker thread
+  so that the buffers retain their capacity from one chunk to the next.
+*/
+struct ChunkMeshBuffers
+{
+  std::vector<ChunkVertex> vertices;
+  std::vector<ChunkFaceRecord> faceRecords;
+  std::vector<ChunkVoxel> voxels;
+  std::vector<u32> indices;
+};
+
+/*
+  Chunk meshes are indexed unless param::FaceRecordMeshes() is enabled, in which case each face
+  record is expanded into two triangles in the shader and no indices are needed.
+*/
+class ChunkDrawCommand : public eng::GenericDrawCommand<ChunkDrawCommand, ChunkSectionID, !param::FaceRecordMeshes()>
 {
   std::vector<ChunkVertex> m_Vertices;
+  std::vector<ChunkFaceRecord> m_FaceRecords;
+  std::vector<ChunkFaceRecord> m_SortedFaceRecords;
   std::vector<ChunkVoxel> m_Voxels;
   std::vector<u32> m_Indices;
+  BlockBox m_VoxelBounds;
   BlockIndex m_SortState;
   bool m_NeedsSorting;
 
-  i32 m_VoxelBaseVertex;
-
 public:
-  ChunkDrawCommand(const GlobalIndex& chunkIndex, bool needsSorting);
+  ChunkDrawCommand(const ChunkSectionID& sectionID, bool needsSorting);
 
   bool operator==(const ChunkDrawCommand& other) const;
 
@@ -64,17 +192,36 @@ public:
   eng::mem::RenderData vertexData() const;
   void clearData();
 
-  void addQuad(const BlockIndex& blockIndex, eng::math::Direction face, block::TextureID texture, const std::array<i32, 4>& sunlight, const std::array<i32, 4>& ambientOcclusion);
+  static constexpr u32 VerticesPerElement() { return ChunkFaceRecord::VerticesPerFace(); }
+
+  void addQuad(const BlockIndex& blockIndex, eng::math::Direction face, block::TextureID texture,
+               const std::array<i32, 4>& sunlight, const std::array<i32, 4>& blockLight, const std::array<i32, 4>& ambientOcclusion);
+
+  /*
+    Adds a quad spanning multiple coplanar block faces. The quad extents are given in blocks along the
+    axes returned by ChunkVertex::GetQuadAxes, with blockIndex being the block at the minimum corner.
+  */
+  void addQuad(const BlockIndex& blockIndex, const BlockIndex2D& quadExtents, eng::math::Direction face, block::TextureID texture,
+               const std::array<i32, 4>& sunlight, const std::array<i32, 4>& blockLight, const std::array<i32, 4>& ambientOcclusion);
   void addVoxel(const BlockIndex& blockIndex, eng::EnumBitMask<eng::math::Direction> enabledFaces);
 
   /*
-    Sorts indices so that triangles will be rendered from back to front.
+    Builds the mesh directly in the given buffers until they are returned, at which point the mesh is
+    copied into storage of the exact size needed. Must be called on a command with no mesh data.
+  */
+  void borrowBuffers(ChunkMeshBuffers& buffers);
+  void returnBuffers(ChunkMeshBuffers& buffers);
+
+  /*
+    Sorts indices, or face records if enabled, so that triangles will be rendered from back to front.
     The sorting algorithm used is O(n + k), where n is the number of voxels
-    and k is the maximum L1 distance that two blocks can be within a chunk.
+    and k is the maximum L1 distance that two blocks can be within a section.
+
+    \returns True if the quad order changed and needs to be re-uploaded.
   */
   bool sort(const GlobalIndex& originIndex, const eng::math::Vec3& viewPosition);
 
 private:
   void addQuadIndices(i32 baseVertex);
-  void reorderIndices(const GlobalIndex& originIndex, const eng::math::Vec3& viewPosition);
+  bool reorderQuads(const GlobalIndex& originIndex, const eng::math::Vec3& viewPosition);
 };
\ No newline at end of file
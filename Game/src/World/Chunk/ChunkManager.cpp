@@ -1,5 +1,7 @@
 #include "GMpch.h"
 #include "ChunkManager.h"
+#include "FaceLighting.h"
+#include "LightPropagation.h"
 #include "Indexing/Operations.h"
 #include "Player/Player.h"
 #include "World/Terrain.h"
@@ -8,6 +10,8 @@
 static constexpr i32 c_TextureSlot = 0;
 static constexpr i32 c_SSBOBinding = 1;
 static constexpr i32 c_LightUniformBinding = 2;
+static constexpr i32 c_FaceRecordBinding = 3;
+static constexpr eng::IndexPolicy c_OpaqueIndexPolicy = param::SharedQuadIndices() && !param::FaceRecordMeshes() ? eng::IndexPolicy::SharedQuads : eng::IndexPolicy::PerCommand;
 static constexpr u32 c_SSBOSize = eng::math::pow2<u32>(20);
 static std::unique_ptr<eng::Shader> s_Shader;
 static std::unique_ptr<eng::Uniform> s_LightUniform;
@@ -16,6 +20,10 @@ static std::shared_ptr<eng::TextureArray> s_TextureArray;
 static const eng::mem::BufferLayout s_VertexBufferLayout = {{ eng::mem::DataType::Unsigned, "a_VertexData" },
                                                             { eng::mem::DataType::Unsigned, "a_Lighting"   }};
 
+// Lighting
+static constexpr globalIndex_t c_LightingRegionSize = 3;  // Chunks per side of a lighting region
+static_assert(c_LightingRegionSize * Chunk::Size() < std::numeric_limits<blockIndex_t>::max(), "Blocks in a lighting region must be addressable by block indices!");
+
 struct LightUniformData
 {
   const f32 maxSunlight = eng::arithmeticUpcast<f32>(block::Light::MaxValue());
@@ -39,8 +47,11 @@ public:
 
   void operator()()
   {
-    m_OpaqueAsyncArray->removeCommand(m_ChunkIndex);
-    m_TransparentAsyncArray->removeCommand(m_ChunkIndex);
+    for (i32 section = 0; section < Chunk::TotalSections(); ++section)
+    {
+      m_OpaqueAsyncArray->removeCommand(ChunkSectionID(m_ChunkIndex, section));
+      m_TransparentAsyncArray->removeCommand(ChunkSectionID(m_ChunkIndex, section));
+    }
   }
 };
 
@@ -55,44 +66,295 @@ struct BlockData
   static constexpr BlockBox Bounds() { return BlockBox(-1, Chunk::Size()); }
 };
 
-// TODO: Remove
-static BlockArrayBox<block::Light> calculateLighting(const BlockArrayBox<block::Type>& composition)
+/*
+  Scratch memory for meshing and lighting tasks. Each worker thread owns its own copy, so these
+  buffers are allocated once per thread and reused for every chunk it processes.
+*/
+struct ScratchBuffers
 {
-  BlockArrayBox<block::Light> lighting(Chunk::Bounds(), eng::AllocationPolicy::Deferred);
-  if (!composition)
-    return lighting;
+  BlockData blockData;
+  ChunkMeshBuffers opaqueMesh;
+  ChunkMeshBuffers transparentMesh;
+  std::array<std::vector<BlockIndex>, block::Light::MaxValue() + 1> lightQueues;
+};
+static thread_local ScratchBuffers tl_Scratch;
+
+/*
+  Bitmasks of visible opaque faces for each direction. Each mask covers a column of blocks running along the axis
+  of the face, where bit n corresponds to the block at position n along that axis. Columns are indexed by the
+  position of the block along the two quad axes of the face.
+*/
+struct FaceMasks
+{
+  static constexpr i32 c_ColumnCount = Chunk::Size() * Chunk::Size();
 
-  lighting.allocate();
-  for (blockIndex_t i = 0; i < Chunk::Size(); ++i)
-    for (blockIndex_t j = 0; j < Chunk::Size(); ++j)
+  eng::EnumArray<std::array<u32, c_ColumnCount>, eng::math::Direction> opaqueFaces;
+  std::array<u32, c_ColumnCount> opaqueBlocks;        // Opaque blocks in columns along the z-axis
+  std::array<u32, c_ColumnCount> transparentBlocks;   // Non-air transparent blocks in columns along the z-axis
+
+  static i32 ColumnIndex(eng::math::Axis axis, const BlockIndex& blockIndex)
+  {
+    const std::array<eng::math::Axis, 2>& quadAxes = ChunkVertex::GetQuadAxes(toDirection(axis, false));
+    return Chunk::Size() * blockIndex[quadAxes[0]] + blockIndex[quadAxes[1]];
+  }
+
+  bool isOpaqueFaceVisible(eng::math::Direction face, const BlockIndex& blockIndex) const
+  {
+    eng::math::Axis axis = axisOf(face);
+    return opaqueFaces[face][ColumnIndex(axis, blockIndex)] & eng::u32Bit(blockIndex[axis]);
+  }
+};
+
+/*
+  Builds face masks from the padded composition. Opacity is computed in bulk for each contiguous row and scattered
+  into padded columns along each axis, after which visible opaque faces are found by shifting each column onto
+  its neighbors.
+*/
+static FaceMasks calculateFaceMasks(const BlockData& blockData)
+{
+  ENG_PROFILE_FUNCTION();
+
+  // Padded columns store the block at position n along the column axis in bit n + 1
+  eng::EnumArray<std::array<u64, FaceMasks::c_ColumnCount>, eng::math::Axis> opaqueColumns{};
+
+  FaceMasks faceMasks{};
+  for (blockIndex_t i = -1; i <= Chunk::Size(); ++i)
+    for (blockIndex_t j = -1; j <= Chunk::Size(); ++j)
     {
-      blockIndex_t k = 0;
-      while (k < Chunk::Size() && !composition[i][j][k].hasTransparency())
+      // Rows along the z-axis are contiguous, so their opacity can be computed in bulk
+      std::span<const block::Type> paddedRow(&blockData.composition[i][j][-1], Chunk::Size() + 2);
+      u64 opaqueRow = block::opacityMask(paddedRow);
+      u32 interiorOpaqueRow = static_cast<u32>(opaqueRow >> 1);
+
+      bool iInterior = eng::withinBounds(i, 0, Chunk::Size());
+      bool jInterior = eng::withinBounds(j, 0, Chunk::Size());
+      if (iInterior && jInterior)
+      {
+        i32 columnIndex = Chunk::Size() * i + j;
+        u64 airRow = block::matchMask(paddedRow, block::ID::Air);
+        opaqueColumns[eng::math::Axis::Z][columnIndex] = opaqueRow;
+        faceMasks.transparentBlocks[columnIndex] = static_cast<u32>(~opaqueRow >> 1) & ~static_cast<u32>(airRow >> 1);
+      }
+
+      // Scatter opaque bits into the columns along the other two axes
+      for (u32 row = interiorOpaqueRow; row; row &= row - 1)
       {
-        lighting[i][j][k] = block::Light(0);
-        k++;
+        blockIndex_t k = eng::arithmeticCast<blockIndex_t>(std::countr_zero(row));
+        if (jInterior)
+          opaqueColumns[eng::math::Axis::X][FaceMasks::ColumnIndex(eng::math::Axis::X, BlockIndex(i, j, k))] |= eng::u64Bit(i + 1);
+        if (iInterior)
+          opaqueColumns[eng::math::Axis::Y][FaceMasks::ColumnIndex(eng::math::Axis::Y, BlockIndex(i, j, k))] |= eng::u64Bit(j + 1);
       }
-      for (; k < Chunk::Size(); ++k)
-        lighting[i][j][k] = block::Light(block::Light::MaxValue());
     }
+
+  for (eng::math::Axis axis : eng::math::Axes())
+    for (i32 columnIndex = 0; columnIndex < FaceMasks::c_ColumnCount; ++columnIndex)
+    {
+      u64 paddedColumn = opaqueColumns[axis][columnIndex];
+      u32 column = static_cast<u32>(paddedColumn >> 1);
+      faceMasks.opaqueFaces[toDirection(axis, false)][columnIndex] = column & ~static_cast<u32>(paddedColumn);
+      faceMasks.opaqueFaces[toDirection(axis, true)][columnIndex] = column & ~static_cast<u32>(paddedColumn >> 2);
+      if (axis == eng::math::Axis::Z)
+        faceMasks.opaqueBlocks[columnIndex] = column;
+    }
+  return faceMasks;
+}
+
+static bool isFaceVisible(const BlockData& blockData, const BlockIndex& blockIndex, block::Type blockType, eng::math::Direction face)
+{
+  block::Type cardinalNeighbor = blockData.composition(blockIndex + BlockIndex::Dir(face));
+  return cardinalNeighbor != blockType && (blockType.hasTransparency() || cardinalNeighbor.hasTransparency());
+}
+
+/*
+  \returns The light of the given channel at each vertex of a face, averaged over the transparent blocks surrounding the vertex.
+*/
+static std::array<i32, 4> calculateQuadLight(const BlockData& blockData, const BlockIndex& blockIndex, eng::math::Direction face, i8 (block::Light::*channel)() const)
+{
+  std::array<i32, 4> light{};
+  for (i32 quadIndex = 0; quadIndex < 4; ++quadIndex)
+  {
+    i32 transparentNeighbors = 0;
+    i32 totalLight = 0;
+
+    BlockIndex vertexPosition = blockIndex + ChunkVertex::GetOffset(face, quadIndex);
+    BlockBox lightingStencil = BlockBox(-1, 0) + vertexPosition;
+    for (const BlockIndex& lightIndex : lightingStencil)
+    {
+      if (!blockData.composition(lightIndex).hasTransparency())
+        continue;
+
+      totalLight += (blockData.lighting(lightIndex).*channel)();
+      transparentNeighbors++;
+    }
+
+    light[quadIndex] = totalLight / std::max(transparentNeighbors, 1);
+  }
+  return light;
+}
+
+static std::array<i32, 4> calculateQuadAmbientOcclusion(const BlockData& blockData, const BlockIndex& blockIndex, eng::math::Direction face)
+{
+  eng::math::Axis u = axisOf(face);
+  eng::math::Axis v = cycle(u);
+  eng::math::Axis w = cycle(v);
+
+  std::array<i32, 4> quadAmbientOcclusion{};
+  for (i32 quadIndex = 0; quadIndex < 4; ++quadIndex)
+  {
+    eng::math::Direction edgeADir = toDirection(v, ChunkVertex::GetOffset(face, quadIndex)[v]);
+    eng::math::Direction edgeBDir = toDirection(w, ChunkVertex::GetOffset(face, quadIndex)[w]);
+
+    BlockIndex edgeA = blockIndex + BlockIndex::Dir(face) + BlockIndex::Dir(edgeADir);
+    BlockIndex edgeB = blockIndex + BlockIndex::Dir(face) + BlockIndex::Dir(edgeBDir);
+    BlockIndex corner = blockIndex + BlockIndex::Dir(face) + BlockIndex::Dir(edgeADir) + BlockIndex::Dir(edgeBDir);
+
+    bool edgeAIsOpaque = !blockData.composition(edgeA).hasTransparency();
+    bool edgeBIsOpaque = !blockData.composition(edgeB).hasTransparency();
+    bool cornerIsOpaque = !blockData.composition(corner).hasTransparency();
+    quadAmbientOcclusion[quadIndex] = edgeAIsOpaque && edgeBIsOpaque ? 3 : edgeAIsOpaque + edgeBIsOpaque + cornerIsOpaque;
+  }
+  return quadAmbientOcclusion;
+}
+
+/*
+  Merges visible opaque faces within a chunk section pointing in the given direction into larger quads. Faces are
+  merged if they are coplanar, share a texture, and have uniform sunlight, block light and ambient occlusion across all four
+  vertices, so that the merged quad is shaded identically to the individual faces. Faces with non-uniform lighting
+  are added as-is.
+*/
+static void addGreedyQuads(ChunkDrawCommand& draw, const BlockData& blockData, const FaceMasks& faceMasks, eng::math::Direction face, const BlockBox& sectionBounds)
+{
+  static constexpr u32 c_FacePresent = eng::u32Bit(31);
+  auto packQuadKey = [](block::TextureID texture, i32 sunlight, i32 blockLight, i32 ambientOcclusion) -> u32
+  {
+    return c_FacePresent | eng::toUnderlying(texture) | sunlight << 12 | ambientOcclusion << 16 | blockLight << 20;
+  };
+
+  eng::math::Axis normalAxis = axisOf(face);
+  const std::array<eng::math::Axis, 2>& quadAxes = ChunkVertex::GetQuadAxes(face);
+  auto toBlockIndex = [normalAxis, &quadAxes](blockIndex_t layer, const BlockIndex2D& layerIndex)
+  {
+    BlockIndex blockIndex;
+    blockIndex[normalAxis] = layer;
+    blockIndex[quadAxes[0]] = layerIndex.i;
+    blockIndex[quadAxes[1]] = layerIndex.j;
+    return blockIndex;
+  };
+
+  BlockRect layerBounds(sectionBounds.min[quadAxes[0]], sectionBounds.min[quadAxes[1]], sectionBounds.max[quadAxes[0]], sectionBounds.max[quadAxes[1]]);
+  u32 sectionLayers = static_cast<u32>((eng::u64Bit(Chunk::SectionSize()) - 1) << sectionBounds.min[normalAxis]);
+
+  // Skip layers that contain no visible faces
+  u32 occupiedLayers = 0;
+  for (const BlockIndex2D& layerIndex : layerBounds)
+    occupiedLayers |= faceMasks.opaqueFaces[face][Chunk::Size() * layerIndex.i + layerIndex.j];
+
+  FaceLightingPlane faceLighting;
+  BlockArrayRect<u32> quadKeys(layerBounds, eng::AllocationPolicy::ForOverwrite);
+  for (u32 layers = occupiedLayers & sectionLayers; layers; layers &= layers - 1)
+  {
+    blockIndex_t layer = eng::arithmeticCast<blockIndex_t>(std::countr_zero(layers));
+    faceLighting.calculate(blockData.composition, blockData.lighting, sectionBounds, face, layer);
+    quadKeys.populate([&draw, &blockData, &faceMasks, &faceLighting, face, layer, &toBlockIndex, &packQuadKey](const BlockIndex2D& layerIndex) -> u32
+    {
+      if (!(faceMasks.opaqueFaces[face][Chunk::Size() * layerIndex.i + layerIndex.j] & eng::u32Bit(layer)))
+        return 0;
+
+      BlockIndex blockIndex = toBlockIndex(layer, layerIndex);
+      block::Type blockType = blockData.composition(blockIndex);
+
+      std::array<i32, 4> sunlight = faceLighting.sunlight(blockIndex);
+      std::array<i32, 4> blockLight = faceLighting.blockLight(blockIndex);
+      std::array<i32, 4> ambientOcclusion = faceLighting.ambientOcclusion(blockIndex);
+      auto isUniform = [](const std::array<i32, 4>& values) { return eng::algo::allOf(values, [&values](i32 value) { return value == values[0]; }); };
+      if (!isUniform(sunlight) || !isUniform(blockLight) || !isUniform(ambientOcclusion))
+      {
+        draw.addQuad(blockIndex, face, blockType.texture(face), sunlight, blockLight, ambientOcclusion);
+        return 0;
+      }
+      return packQuadKey(blockType.texture(face), sunlight[0], blockLight[0], ambientOcclusion[0]);
+    });
+
+    for (blockIndex_t v = layerBounds.min.j; v <= layerBounds.max.j; ++v)
+      for (blockIndex_t u = layerBounds.min.i; u <= layerBounds.max.i; ++u)
+      {
+        u32 quadKey = quadKeys[u][v];
+        if (quadKey == 0)
+          continue;
+
+        // Grow quad along u-axis, then along v-axis for as long as every face in the new row matches
+        blockIndex_t width = 1;
+        while (u + width <= layerBounds.max.i && quadKeys[u + width][v] == quadKey)
+          width++;
+
+        auto rowMatches = [&quadKeys, u, width, quadKey](blockIndex_t row)
+        {
+          for (blockIndex_t n = u; n < u + width; ++n)
+            if (quadKeys[n][row] != quadKey)
+              return false;
+          return true;
+        };
+
+        blockIndex_t height = 1;
+        while (v + height <= layerBounds.max.j && rowMatches(v + height))
+          height++;
+
+        BlockRect quadRect(u, v, u + width - 1, v + height - 1);
+        quadKeys.fill(quadRect, 0);
+
+        block::TextureID texture = eng::enumCastUnchecked<block::TextureID>(quadKey & 0xFFF);
+        std::array<i32, 4> sunlight{};
+        std::array<i32, 4> blockLight{};
+        std::array<i32, 4> ambientOcclusion{};
+        sunlight.fill((quadKey >> 12) & 0xF);
+        blockLight.fill((quadKey >> 20) & 0xF);
+        ambientOcclusion.fill((quadKey >> 16) & 0x3);
+        draw.addQuad(toBlockIndex(layer, quadRect.min), BlockIndex2D(width, height), face, texture, sunlight, blockLight, ambientOcclusion);
+      }
+  }
+}
+
+/*
+  Initial lighting of a newly generated chunk, before anything is known about its neighbors.
+  Blocks above the topmost opaque block of each column receive full sunlight.
+*/
+static BlockArrayBox<block::Light> calculateLighting(const Chunk& chunk)
+{
+  BlockArrayBox<block::Light> lighting(Chunk::Bounds(), eng::AllocationPolicy::Deferred);
+  if (!chunk.composition())
+    return lighting;
+
+  lighting.allocate();
+  for (const BlockIndex2D& column : Chunk::Bounds2D())
+  {
+    blockIndex_t topOpaqueBlock = chunk.topOpaqueBlock(column);
+    for (BlockIndex blockIndex(column, 0); blockIndex.k < Chunk::Size(); ++blockIndex.k)
+      lighting(blockIndex) = block::Light(blockIndex.k > topOpaqueBlock ? block::Light::MaxValue() : 0);
+  }
   return lighting;
 }
 
+static GlobalIndex lightingRegion(const GlobalIndex& chunkIndex)
+{
+  return eng::clone(chunkIndex).flooredDivide(c_LightingRegionSize);
+}
+
 
 
 ChunkManager::ChunkManager()
-  : m_OpaqueMultiDrawArray(std::make_shared<eng::thread::AsyncMultiDrawArray<ChunkDrawCommand>>(s_VertexBufferLayout)),
+  : m_OpaqueMultiDrawArray(std::make_shared<eng::thread::AsyncMultiDrawArray<ChunkDrawCommand>>(s_VertexBufferLayout, c_OpaqueIndexPolicy)),
     m_TransparentMultiDrawArray(std::make_shared<eng::thread::AsyncMultiDrawArray<ChunkDrawCommand>>(s_VertexBufferLayout)),
     m_ThreadPool(std::make_shared<eng::thread::ThreadPool>("Chunk Manager", 0.25)),
     m_LoadWork(m_ThreadPool, eng::thread::Priority::Normal),
     m_CleanWork(m_ThreadPool, eng::thread::Priority::High),
     m_LightingWork(m_ThreadPool, eng::thread::Priority::Normal),
     m_LazyMeshingWork(m_ThreadPool, eng::thread::Priority::Normal),
-    m_ForceMeshingWork(m_ThreadPool, eng::thread::Priority::Immediate)
+    m_ForceMeshingWork(m_ThreadPool, eng::thread::Priority::Immediate))
 {
   ENG_PROFILE_FUNCTION();
 
-  s_Shader = eng::Shader::Create("assets/shaders/Chunk.glsl");
+  s_Shader = eng::Shader::Create(param::FaceRecordMeshes() ? "assets/shaders/ChunkFaceRecords.glsl" : "assets/shaders/Chunk.glsl");
   s_LightUniform = std::make_unique<eng::Uniform>("Light", c_LightUniformBinding, sizeof(LightUniformData));
   s_TextureArray = block::getTextureArray();
   s_SSBO = std::make_unique<eng::ShaderBufferStorage>(c_SSBOBinding, c_SSBOSize);
@@ -125,14 +387,17 @@ void ChunkManager::render()
   eng::math::Vec3 cameraPosition = activeCameraEntity.get<eng::component::Transform>().position;
   GlobalIndex originIndex = player::originIndex();
 
-  auto isInViewFrustum = [&frustumPlanes, &originIndex](const GlobalIndex& chunkIndex)
+  auto isInViewFrustum = [&frustumPlanes, &originIndex](const ChunkSectionID& sectionID)
   {
-    eng::math::Vec3 chunkCenter = indexCenter(chunkIndex, originIndex);
-    return isInRange(chunkIndex, originIndex, param::RenderDistance()) && eng::math::isInFrustum(chunkCenter, frustumPlanes);
+    eng::math::Vec3 chunkCenter = indexCenter(sectionID.chunkIndex, originIndex);
+    return isInRange(sectionID.chunkIndex, originIndex, param::RenderDistance()) && eng::math::isInFrustum(chunkCenter, frustumPlanes);
   };
-  auto chunkDistance = [&originIndex](const GlobalIndex& chunkIndex)
+  auto sectionDistance = [&originIndex, &cameraPosition](const ChunkSectionID& sectionID)
   {
-    return (chunkIndex - originIndex).l1Norm();
+    BlockBox sectionBounds = Chunk::SectionBounds(sectionID.section);
+    eng::math::Vec3 sectionCenter = indexPosition(sectionID.chunkIndex, originIndex) + block::length() * (eng::math::Vec3(sectionBounds.min) + Chunk::SectionSize() / 2.0f);
+    eng::math::Vec3 toSection = sectionCenter - cameraPosition;
+    return glm::dot(toSection, toSection);
   };
   auto draw = [&originIndex](const eng::MultiDrawArray<ChunkDrawCommand>& multiDrawArray, uSize commandCount)
   {
@@ -142,14 +407,20 @@ void ChunkManager::render()
     storageBufferData.reserve(commandCount);
     for (uSize i = 0; i < commandCount; ++i)
     {
-      const GlobalIndex& chunkIndex = drawCommands[i].id();
+      const GlobalIndex& chunkIndex = drawCommands[i].id().chunkIndex;
       eng::math::Vec3 chunkAnchorPosition = indexPosition(chunkIndex, originIndex);
       storageBufferData.emplace_back(chunkAnchorPosition, 0);
     }
     s_SSBO->write(storageBufferData);
 
     multiDrawArray.bind();
-    eng::render::command::multiDrawIndexed(drawCommands, commandCount);
+    if constexpr (param::FaceRecordMeshes())
+    {
+      multiDrawArray.bindVertexStorage(c_FaceRecordBinding);
+      eng::render::command::multiDrawVertices(drawCommands, commandCount);
+    }
+    else
+      eng::render::command::multiDrawIndexed(drawCommands, commandCount);
   };
 
   s_Shader->bind();
@@ -158,10 +429,10 @@ void ChunkManager::render()
   eng::render::command::setFaceCulling(true);
   eng::render::command::setDepthWriting(true);
   eng::render::command::setUseDepthOffset(false);
-  m_OpaqueMultiDrawArray->drawOperation([&isInViewFrustum, &chunkDistance, &draw](eng::MultiDrawArray<ChunkDrawCommand>& multiDrawArray)
+  m_OpaqueMultiDrawArray->drawOperation([&isInViewFrustum, &sectionDistance, &draw](eng::MultiDrawArray<ChunkDrawCommand>& multiDrawArray)
   {
     uSize commandCount = multiDrawArray.partition(isInViewFrustum);
-    multiDrawArray.sort(commandCount, chunkDistance, eng::SortPolicy::Ascending);   // Sort opaque meshes front-to-back
+    multiDrawArray.sort(commandCount, sectionDistance, eng::SortPolicy::Ascending);   // Sort opaque meshes front-to-back
     draw(multiDrawArray, commandCount);
   });
 
@@ -170,15 +441,19 @@ void ChunkManager::render()
   eng::render::command::setDepthWriting(false);
   eng::render::command::setUseDepthOffset(true);
   eng::render::command::setDepthOffset(1.0f, 1.0f);
-  m_TransparentMultiDrawArray->drawOperation([&isInViewFrustum, &chunkDistance, &draw, &originIndex, &cameraPosition](eng::MultiDrawArray<ChunkDrawCommand>& multiDrawArray)
+  m_TransparentMultiDrawArray->drawOperation([&isInViewFrustum, &sectionDistance, &draw, &originIndex, &cameraPosition](eng::MultiDrawArray<ChunkDrawCommand>& multiDrawArray)
   {
     uSize commandCount = multiDrawArray.partition(isInViewFrustum);
-    multiDrawArray.sort(commandCount, chunkDistance, eng::SortPolicy::Descending);  // Sort transparent meshes back-to-front
-    multiDrawArray.modifyIndices(commandCount, [&originIndex, &cameraPosition](ChunkDrawCommand& drawCommand)
+    multiDrawArray.sort(commandCount, sectionDistance, eng::SortPolicy::Descending);  // Sort transparent meshes back-to-front
+    auto sortQuads = [&originIndex, &cameraPosition](ChunkDrawCommand& drawCommand)
     {
       bool orderModified = drawCommand.sort(originIndex, cameraPosition);
       return orderModified;
-    });
+    };
+    if constexpr (param::FaceRecordMeshes())
+      multiDrawArray.modifyVertices(eng::arithmeticCast<i32>(commandCount), sortQuads);
+    else
+      multiDrawArray.modifyIndices(commandCount, sortQuads);
 
     draw(multiDrawArray, commandCount);
   });
@@ -220,7 +495,7 @@ void ChunkManager::loadNewChunks()
       newChunkIndices.insert(player::originIndex());
 
     for (const GlobalIndex& newChunkIndex : newChunkIndices)
-      m_LoadWork.submitAndSaveResult(newChunkIndex, &ChunkManager::generateNewChunk, this, newChunkIndex);
+      m_LoadWork.submitAndSaveResult(newChunkIndex, &ChunkManager::loadChunk, this, newChunkIndex);
   });
 
   lastSearchTimePoint = std::chrono::steady_clock::now();
@@ -252,6 +527,9 @@ void ChunkManager::clean()
     {
       return !isInRange(chunkIndex, originIndex, param::UnloadDistance());
     });
+    for (const GlobalIndex& chunkIndex : m_ChunkContainer.knownEmptyIndices())
+      if (!isInRange(chunkIndex, originIndex, param::UnloadDistance()))
+        chunksMarkedForDeletion.push_back(chunkIndex);
 
     for (const GlobalIndex& chunkIndex : chunksMarkedForDeletion)
       m_CleanWork.submitAndSaveResult(chunkIndex, &ChunkManager::eraseChunk, this, chunkIndex);
@@ -280,6 +558,15 @@ void ChunkManager::placeBlock(GlobalIndex chunkIndex, BlockIndex blockIndex, eng
     blockIndex += BlockIndex::Dir(face);
 
   std::shared_ptr<Chunk> chunk = m_ChunkContainer.chunks().get(chunkIndex);
+  if (!chunk && m_ChunkContainer.isKnownEmpty(chunkIndex))
+  {
+    // Blocks placed in known empty space require the chunk to be generated. Another thread may insert it
+    // first, in which case the block must be placed in the chunk that actually made it into the container.
+    std::shared_ptr<Chunk> newChunk = generateNewChunk(chunkIndex);
+    chunk = m_ChunkContainer.chunks().get(chunkIndex);
+    if (chunk && chunk == newChunk)
+      markReady(chunkIndex);
+  }
   if (!chunk)
     return;
 
@@ -295,8 +582,24 @@ void ChunkManager::placeBlock(GlobalIndex chunkIndex, BlockIndex blockIndex, eng
     return;
   }
 
-  if (!blockType.hasTransparency())
-    addToLightingUpdateQueue(chunkIndex);
+  // The light propagator below carries full sunlight down the column across chunk borders, so the chunks whose
+  // exposure changes are already relit. Their exposure only needs to be correct for later full relights.
+  if (chunk->updateHeightmap(blockIndex))
+    m_ChunkContainer.updateSkyExposure(chunkIndex + GlobalIndex::Dir(eng::math::Direction::Bottom));
+
+  if (!blockType.hasTransparency() || blockType.lightEmission() > 0)
+  {
+    // Remove the light that passed through the block, then refill the darkened region from its surroundings.
+    // Light-emitting blocks that let light through only need to spread their own light.
+    LightPropagator lightPropagator(m_ChunkContainer.chunks());
+    if (blockType.hasTransparency())
+      lightPropagator.addEmitter(chunkIndex, blockIndex);
+    else
+      lightPropagator.removeSource(chunkIndex, blockIndex);
+    lightPropagator.propagate();
+    for (const auto& [updateIndex, sectionMask] : lightPropagator.affectedSections())
+      addToLazyMeshUpdateQueue(updateIndex, sectionMask);
+  }
   sendBlockUpdate(chunkIndex, blockIndex);
 }
 
@@ -307,52 +610,79 @@ void ChunkManager::removeBlock(const GlobalIndex& chunkIndex, const BlockIndex&
     return;
   block::Type removedBlock = chunk->composition().replace(blockIndex, block::ID::Air);
 
-  if (!removedBlock.hasTransparency())
-  {
-    // Get estimate of light value of effected block for immediate meshing
-    i8 lightEstimate = 0;
-    for (eng::math::Direction direction : eng::math::Directions())
-    {
-      BlockIndex blockNeighbor = blockIndex + BlockIndex::Dir(direction);
-      if (!Chunk::Bounds().encloses(blockNeighbor) || !chunk->composition().get(blockNeighbor).hasTransparency())
-        continue;
-
-      lightEstimate = std::max(lightEstimate, chunk->lighting().get(blockNeighbor).sunlight());
-    }
-
-    // This is necessary to ensure non-identical diffs of chunk boundary so that lighting updates get propogate to neighboring chunks
-    lightEstimate = std::max(0, lightEstimate - 2);
+  // As with placement, the light propagator below relights the chunks whose exposure changes
+  if (chunk->updateHeightmap(blockIndex))
+    m_ChunkContainer.updateSkyExposure(chunkIndex + GlobalIndex::Dir(eng::math::Direction::Bottom));
 
-    chunk->lighting().set(blockIndex, lightEstimate);
-    addToLightingUpdateQueue(chunkIndex);
+  if (!removedBlock.hasTransparency() || removedBlock.lightEmission() > 0)
+  {
+    // Light flows into the opened space from its neighbors. This is done before meshing so that
+    // the immediate re-mesh of the surrounding sections already has the final lighting.
+    // Light emitted by the removed block is removed along with it.
+    LightPropagator lightPropagator(m_ChunkContainer.chunks());
+    lightPropagator.removeSource(chunkIndex, blockIndex);
+    lightPropagator.addNeighborsAsSources(chunkIndex, blockIndex);
+    lightPropagator.propagate();
+    for (const auto& [updateIndex, sectionMask] : lightPropagator.affectedSections())
+      addToLazyMeshUpdateQueue(updateIndex, sectionMask);
   }
   sendBlockUpdate(chunkIndex, blockIndex);
 }
 
 
 
-void ChunkManager::addToLightingUpdateQueue(const GlobalIndex& chunkIndex)
+void ChunkManager::markReady(const GlobalIndex& chunkIndex)
 {
-  m_LightingWork.submit(chunkIndex, &ChunkManager::lightingTask, this, chunkIndex);
+  std::shared_ptr<Chunk> chunk = m_ChunkContainer.chunks().get(chunkIndex);
+  if (chunk && chunk->advanceState(Chunk::State::Generated, Chunk::State::Ready))
+    addToLightingUpdateQueue(chunkIndex);
 }
 
-void ChunkManager::addToLazyMeshUpdateQueue(const GlobalIndex& chunkIndex)
+void ChunkManager::addToLightingUpdateQueue(const GlobalIndex& chunkIndex)
 {
-  if (m_ForceMeshingWork.contains(chunkIndex))
-    return;
+  GlobalIndex regionIndex = lightingRegion(chunkIndex);
+  {
+    std::lock_guard lock(m_DirtyLightingMutex);
+    m_DirtyLighting[regionIndex].insert(chunkIndex);
+  }
+  m_LightingWork.submit(regionIndex, &ChunkManager::lightingTask, this, regionIndex);
+}
 
+void ChunkManager::addToLazyMeshUpdateQueue(const GlobalIndex& chunkIndex, u64 sectionMask)
+{
+  {
+    std::lock_guard lock(m_PendingMeshingMutex);
+    m_PendingMeshing[chunkIndex] |= sectionMask;
+  }
   m_LazyMeshingWork.submit(chunkIndex, &ChunkManager::lazyMeshingTask, this, chunkIndex);
 }
 
-void ChunkManager::addToForceMeshUpdateQueue(const GlobalIndex& chunkIndex)
+void ChunkManager::addToForceMeshUpdateQueue(const ChunkSectionID& sectionID)
 {
-  m_ForceMeshingWork.submitAndSaveResult(chunkIndex, &ChunkManager::forceMeshingTask, this, chunkIndex);
+  m_ForceMeshingWork.submitAndSaveResult(sectionID, &ChunkManager::forceMeshingTask, this, sectionID);
 }
 
 void ChunkManager::removeMeshes(const GlobalIndex& chunkIndex)
 {
-  m_OpaqueMultiDrawArray->removeCommand(chunkIndex);
-  m_TransparentMultiDrawArray->removeCommand(chunkIndex);
+  for (i32 section = 0; section < Chunk::TotalSections(); ++section)
+  {
+    m_OpaqueMultiDrawArray->removeCommand(ChunkSectionID(chunkIndex, section));
+    m_TransparentMultiDrawArray->removeCommand(ChunkSectionID(chunkIndex, section));
+  }
+}
+
+std::shared_ptr<Chunk> ChunkManager::loadChunk(const GlobalIndex& chunkIndex)
+{
+  // Chunks above the terrain surface are provably air, so they are only recorded as known empty
+  if (terrain::isKnownEmpty(chunkIndex))
+  {
+    std::vector<GlobalIndex> readyIndices;
+    if (m_ChunkContainer.insertKnownEmpty(chunkIndex, readyIndices))
+      for (const GlobalIndex& readyIndex : readyIndices)
+        markReady(readyIndex);
+    return nullptr;
+  }
+  return generateNewChunk(chunkIndex);
 }
 
 std::shared_ptr<Chunk> ChunkManager::generateNewChunk(const GlobalIndex& chunkIndex)
@@ -362,36 +692,63 @@ std::shared_ptr<Chunk> ChunkManager::generateNewChunk(const GlobalIndex& chunkIn
   eng::mem::UponDeallocation<DeallocatorPayload, Chunk> chunkAllocator(chunkIndex, m_OpaqueMultiDrawArray, m_TransparentMultiDrawArray);
   std::shared_ptr<Chunk> chunk = std::allocate_shared<Chunk>(chunkAllocator, chunkIndex);
 
-  BlockArrayBox<block::Type> composition = terrain::generateNew(chunkIndex);
-  BlockArrayBox<block::Light> lighting = calculateLighting(composition);
-  chunk->setComposition(std::move(composition));
-  chunk->setLighting(std::move(lighting));
+  chunk->setComposition(terrain::generateNew(chunkIndex));
+  chunk->setLighting(calculateLighting(*chunk));
 
-  bool insertionSuccess = m_ChunkContainer.insert(chunkIndex, std::move(chunk));
+  std::vector<GlobalIndex> readyIndices;
+  bool insertionSuccess = m_ChunkContainer.insert(chunkIndex, chunk, readyIndices);
   if (insertionSuccess)
-    for (const GlobalIndex& stencilIndex : Chunk::Stencil(chunkIndex))
-      addToLazyMeshUpdateQueue(stencilIndex);
+  {
+    // Lit chunks below may have lost their sky exposure to the new chunk. The new chunk is lit once it is ready.
+    for (const GlobalIndex& updateIndex : m_ChunkContainer.updateSkyExposure(chunkIndex))
+      if (updateIndex != chunkIndex)
+        addToLightingUpdateQueue(updateIndex);
+
+    for (const GlobalIndex& readyIndex : readyIndices)
+      markReady(readyIndex);
+
+    // Neighbors that became ready without this chunk were meshed as if it were air
+    for (const GlobalIndex& neighborIndex : Chunk::Stencil(chunkIndex))
+    {
+      std::shared_ptr<Chunk> neighbor = neighborIndex == chunkIndex ? nullptr : m_ChunkContainer.chunks().get(neighborIndex);
+      if (neighbor && neighbor->state() >= Chunk::State::Lit)
+        addToLazyMeshUpdateQueue(neighborIndex);
+    }
+  }
   return chunk;
 }
 
 void ChunkManager::eraseChunk(const GlobalIndex& chunkIndex)
 {
-  if (!isInRange(chunkIndex, player::originIndex(), param::UnloadDistance()))
-    m_ChunkContainer.erase(chunkIndex);
+  // Chunks below an unloaded chunk are not relit. Treating the missing chunk as open sky would flood them with
+  // sunlight, and they are relit with their correct exposure if the chunk above is loaded again.
+  if (!isInRange(chunkIndex, player::originIndex(), param::UnloadDistance()) && m_ChunkContainer.erase(chunkIndex))
+    m_ChunkContainer.updateSkyExposure(chunkIndex + GlobalIndex::Dir(eng::math::Direction::Bottom));
 }
 
 void ChunkManager::sendBlockUpdate(const GlobalIndex& chunkIndex, const BlockIndex& blockIndex)
 {
+  BlockBox affectedBlocks = BlockBox(blockIndex, blockIndex).expand();
   for (const LocalIndex& localIndex : affectedChunks(blockIndex))
   {
     GlobalIndex neighborIndex = chunkIndex + localIndex.upcast<globalIndex_t>();
-    localIndex.l1Norm() > 1 ? addToLazyMeshUpdateQueue(neighborIndex) : addToForceMeshUpdateQueue(neighborIndex);
+    if (localIndex.l1Norm() > 1)
+    {
+      addToLazyMeshUpdateQueue(neighborIndex, affectedSections(blockIndex - Chunk::Size() * localIndex.checkedCast<blockIndex_t>()));
+      continue;
+    }
+
+    // Only re-mesh the sections of the neighbor that the block update can reach
+    BlockBox neighborAffectedBlocks = affectedBlocks - Chunk::Size() * localIndex.checkedCast<blockIndex_t>();
+    for (i32 section = 0; section < Chunk::TotalSections(); ++section)
+      if (Chunk::SectionBounds(section).overlapsWith(neighborAffectedBlocks))
+        addToForceMeshUpdateQueue(ChunkSectionID(neighborIndex, section));
   }
 }
 
 
 
-void ChunkManager::meshChunk(const Chunk& chunk)
+void ChunkManager::meshChunk(const Chunk& chunk, u64 sectionMask)
 {
   const GlobalIndex& chunkIndex = chunk.globalIndex();
 
@@ -403,235 +760,420 @@ void ChunkManager::meshChunk(const Chunk& chunk)
   }
   ENG_PROFILE_FUNCTION();
 
-  BlockData blockData;
-  blockData.composition = m_ChunkContainer.retrieveTypeData(chunk, { BlockData::Bounds() });
-  blockData.lighting = m_ChunkContainer.retrieveLightingData(chunk, { BlockData::Bounds() });
-
-  ChunkDrawCommand opaqueDraw(chunkIndex, false);
-  ChunkDrawCommand transparentDraw(chunkIndex, true);
-  for (const BlockIndex& blockIndex : Chunk::Bounds())
-  {
-    block::Type blockType = blockData.composition(blockIndex);
+  BlockData& blockData = tl_Scratch.blockData;
+  m_ChunkContainer.retrieveTypeData(blockData.composition, chunk, { BlockData::Bounds() });
+  m_ChunkContainer.retrieveLightingData(blockData.lighting, chunk, { BlockData::Bounds() });
 
-    if (blockType == block::ID::Air)
-      continue;
+  FaceMasks faceMasks = calculateFaceMasks(blockData);
 
-    eng::EnumBitMask<eng::math::Direction> enabledFaces;
-    ChunkDrawCommand& draw = blockType.hasTransparency() ? transparentDraw : opaqueDraw;
-    for (eng::math::Direction face : eng::math::Directions())
+  for (u64 sections = sectionMask; sections; sections &= sections - 1)
+  {
+    ChunkSectionID sectionID(chunkIndex, std::countr_zero(sections));
+    BlockBox sectionBounds = Chunk::SectionBounds(sectionID.section);
+    u32 sectionColumn = static_cast<u32>((eng::u64Bit(Chunk::SectionSize()) - 1) << sectionBounds.min.k);
+
+    ChunkDrawCommand opaqueDraw(sectionID, false);
+    ChunkDrawCommand transparentDraw(sectionID, true);
+    opaqueDraw.borrowBuffers(tl_Scratch.opaqueMesh);
+    transparentDraw.borrowBuffers(tl_Scratch.transparentMesh);
+    for (const BlockIndex2D& columnIndex : static_cast<BlockRect>(sectionBounds))
     {
-      BlockIndex cardinalIndex = blockIndex + BlockIndex::Dir(face);
-      block::Type cardinalNeighbor = blockData.composition(cardinalIndex);
-      if (cardinalNeighbor == blockType || (!blockType.hasTransparency() && !cardinalNeighbor.hasTransparency()))
-        continue;
-
-      enabledFaces.set(face);
+      i32 column = Chunk::Size() * columnIndex.i + columnIndex.j;
 
-      // Calculate lighting
-      std::array<i32, 4> sunlight{};
-      for (i32 quadIndex = 0; quadIndex < 4; ++quadIndex)
+      // Opaque faces are merged into larger quads after all transparent voxels have been meshed
+      u32 opaqueBlocks = param::GreedyMeshing() ? 0 : faceMasks.opaqueBlocks[column];
+      for (u32 blocks = (faceMasks.transparentBlocks[column] | opaqueBlocks) & sectionColumn; blocks; blocks &= blocks - 1)
       {
-        i32 transparentNeighbors = 0;
-        i32 totalSunlight = 0;
+        BlockIndex blockIndex(columnIndex.i, columnIndex.j, eng::arithmeticCast<blockIndex_t>(std::countr_zero(blocks)));
+        block::Type blockType = blockData.composition(blockIndex);
 
-        BlockIndex vertexPosition = blockIndex + ChunkVertex::GetOffset(face, quadIndex);
-        BlockBox lightingStencil = BlockBox(-1, 0) + vertexPosition;
-        for (const BlockIndex& lightIndex : lightingStencil)
+        eng::EnumBitMask<eng::math::Direction> enabledFaces;
+        ChunkDrawCommand& draw = blockType.hasTransparency() ? transparentDraw : opaqueDraw;
+        for (eng::math::Direction face : eng::math::Directions())
         {
-          if (!blockData.composition(lightIndex).hasTransparency())
+          bool faceVisible = blockType.hasTransparency() ? isFaceVisible(blockData, blockIndex, blockType, face) : faceMasks.isOpaqueFaceVisible(face, blockIndex);
+          if (!faceVisible)
             continue;
 
-          totalSunlight += blockData.lighting(lightIndex).sunlight();
-          transparentNeighbors++;
+          enabledFaces.set(face);
+
+          std::array<i32, 4> sunlight = calculateQuadLight(blockData, blockIndex, face, &block::Light::sunlight);
+          std::array<i32, 4> blockLight = calculateQuadLight(blockData, blockIndex, face, &block::Light::blockLight);
+          std::array<i32, 4> ambientOcclusion = blockType.hasTransparency() ? std::array<i32, 4>{} : calculateQuadAmbientOcclusion(blockData, blockIndex, face);
+          draw.addQuad(blockIndex, face, blockType.texture(face), sunlight, blockLight, ambientOcclusion);
         }
 
-        sunlight[quadIndex] = totalSunlight / std::max(transparentNeighbors, 1);
+        if (!enabledFaces.empty())
+          draw.addVoxel(blockIndex, enabledFaces);
       }
+    }
 
-      // Calculate ambient occlusion
-      std::array<i32, 4> quadAmbientOcclusion{};
-      if (!blockType.hasTransparency())
-        for (i32 quadIndex = 0; quadIndex < 4; ++quadIndex)
-        {
-          eng::math::Axis u = axisOf(face);
-          eng::math::Axis v = cycle(u);
-          eng::math::Axis w = cycle(v);
+    if (param::GreedyMeshing())
+      for (eng::math::Direction face : eng::math::Directions())
+        addGreedyQuads(opaqueDraw, blockData, faceMasks, face, sectionBounds);
 
-          eng::math::Direction edgeADir = toDirection(v, ChunkVertex::GetOffset(face, quadIndex)[v]);
-          eng::math::Direction edgeBDir = toDirection(w, ChunkVertex::GetOffset(face, quadIndex)[w]);
+    opaqueDraw.returnBuffers(tl_Scratch.opaqueMesh);
+    transparentDraw.returnBuffers(tl_Scratch.transparentMesh);
+    m_OpaqueMultiDrawArray->queueCommand(std::move(opaqueDraw));
+    m_TransparentMultiDrawArray->queueCommand(std::move(transparentDraw));
+  }
+}
 
-          BlockIndex edgeA = blockIndex + BlockIndex::Dir(face) + BlockIndex::Dir(edgeADir);
-          BlockIndex edgeB = blockIndex + BlockIndex::Dir(face) + BlockIndex::Dir(edgeBDir);
-          BlockIndex corner = blockIndex + BlockIndex::Dir(face) + BlockIndex::Dir(edgeADir) + BlockIndex::Dir(edgeBDir);
+void ChunkManager::benchmarkFaceLighting() const
+{
+  static constexpr i32 c_Iterations = 20;
+  enum class Method { PerFace, ScalarPlanes, SimdPlanes };
 
-          bool edgeAIsOpaque = !blockData.composition(edgeA).hasTransparency();
-          bool edgeBIsOpaque = !blockData.composition(edgeB).hasTransparency();
-          bool cornerIsOpaque = !blockData.composition(corner).hasTransparency();
-          quadAmbientOcclusion[quadIndex] = edgeAIsOpaque && edgeBIsOpaque ? 3 : edgeAIsOpaque + edgeBIsOpaque + cornerIsOpaque;
-        }
+  std::shared_ptr<const Chunk> chunk = m_ChunkContainer.chunks().get(player::originIndex());
+  if (!chunk || !chunk->composition())
+  {
+    ENG_INFO("No chunk with blocks to benchmark face lighting on");
+    return;
+  }
 
-      draw.addQuad(blockIndex, face, blockType.texture(face), sunlight, quadAmbientOcclusion);
-    }
+  BlockData blockData;
+  m_ChunkContainer.retrieveTypeData(blockData.composition, *chunk, { BlockData::Bounds() });
+  m_ChunkContainer.retrieveLightingData(blockData.lighting, *chunk, { BlockData::Bounds() });
+  FaceMasks faceMasks = calculateFaceMasks(blockData);
 
-    if (!enabledFaces.empty())
-      draw.addVoxel(blockIndex, enabledFaces);
-  }
+  // Lights every visible opaque face of the chunk with the given method. Returns a checksum of the results.
+  auto lightFaces = [&blockData, &faceMasks](std::string_view name, Method method)
+  {
+    u64 checksum = 0;
+    FaceLightingPlane faceLighting;
+
+    eng::debug::Timer timer(name);
+    timer.timeStart();
+    for (i32 iteration = 0; iteration < c_Iterations; ++iteration)
+      for (i32 section = 0; section < Chunk::TotalSections(); ++section)
+        for (eng::math::Direction face : eng::math::Directions())
+        {
+          BlockBox sectionBounds = Chunk::SectionBounds(section);
+          eng::math::Axis normalAxis = axisOf(face);
+          for (blockIndex_t layer = sectionBounds.min[normalAxis]; layer <= sectionBounds.max[normalAxis]; ++layer)
+          {
+            BlockBox layerBounds = sectionBounds;
+            layerBounds.min[normalAxis] = layer;
+            layerBounds.max[normalAxis] = layer;
+
+            bool layerCalculated = false;
+            for (const BlockIndex& blockIndex : layerBounds)
+            {
+              if (!faceMasks.isOpaqueFaceVisible(face, blockIndex))
+                continue;
+
+              if (method != Method::PerFace && !layerCalculated)
+              {
+                faceLighting.calculate(blockData.composition, blockData.lighting, sectionBounds, face, layer, method == Method::SimdPlanes);
+                layerCalculated = true;
+              }
+
+              bool usePlanes = method != Method::PerFace;
+              std::array<i32, 4> sunlight = usePlanes ? faceLighting.sunlight(blockIndex) : calculateQuadLight(blockData, blockIndex, face, &block::Light::sunlight);
+              std::array<i32, 4> blockLight = usePlanes ? faceLighting.blockLight(blockIndex) : calculateQuadLight(blockData, blockIndex, face, &block::Light::blockLight);
+              std::array<i32, 4> ambientOcclusion = usePlanes ? faceLighting.ambientOcclusion(blockIndex) : calculateQuadAmbientOcclusion(blockData, blockIndex, face);
+              for (i32 quadIndex = 0; quadIndex < 4; ++quadIndex)
+                checksum = 31 * checksum + 64 * blockLight[quadIndex] + 4 * sunlight[quadIndex] + ambientOcclusion[quadIndex];
+            }
+          }
+        }
+    timer.timeStop();
+    return checksum;
+  };
 
-  m_OpaqueMultiDrawArray->queueCommand(std::move(opaqueDraw));
-  m_TransparentMultiDrawArray->queueCommand(std::move(transparentDraw));
+  u64 perFaceChecksum = lightFaces("Per-face lighting", Method::PerFace);
+  u64 scalarChecksum = lightFaces("Scalar plane lighting", Method::ScalarPlanes);
+  u64 simdChecksum = lightFaces("SIMD plane lighting", Method::SimdPlanes);
+  bool methodsAgree = scalarChecksum == perFaceChecksum && simdChecksum == perFaceChecksum;
+  ENG_INFO("Face lighting methods {0}", methodsAgree ? "agree" : "do not agree");
 }
 
-void ChunkManager::updateLighting(Chunk& chunk)
+void ChunkManager::updateLighting(const GlobalIndex& regionIndex, const std::vector<std::shared_ptr<Chunk>>& chunks)
 {
   ENG_PROFILE_FUNCTION();
 
   static constexpr i8 attenuation = 1;
-  const GlobalIndex& chunkIndex = chunk.globalIndex();
 
-  BlockData blockData;
-
-  // Only need data from cardinal neighbors for lighting updates
-  std::vector<BlockBox> chunkSections = eng::algo::asVector(eng::math::FaceInteriors(BlockData::Bounds()));
-  blockData.lighting = m_ChunkContainer.retrieveLightingData(chunk, chunkSections);
+  // Blocks of the region are indexed relative to the first chunk of the region
+  GlobalIndex regionOrigin = c_LightingRegionSize * regionIndex;
+  auto chunkOffset = [&regionOrigin](const GlobalIndex& chunkIndex)
+  {
+    return Chunk::Size() * (chunkIndex - regionOrigin).checkedCast<blockIndex_t>();
+  };
 
-  chunkSections.push_back(Chunk::Bounds());
-  blockData.composition = m_ChunkContainer.retrieveTypeData(chunk, chunkSections);
+  // Tracks which chunks of the region are part of the batch. Only blocks in these chunks are relit.
+  std::array<bool, eng::math::cube(c_LightingRegionSize)> dirtyChunks{};
+  auto dirtyChunkSlot = [](const LocalIndex& regionChunk)
+  {
+    return eng::math::square(c_LightingRegionSize) * regionChunk.i + c_LightingRegionSize * regionChunk.j + regionChunk.k;
+  };
+  auto isDirty = [&dirtyChunks, &dirtyChunkSlot](const BlockIndex& blockIndex)
+  {
+    LocalIndex regionChunk = blockIndex.upcast<localIndex_t>().flooredDivide(Chunk::Size());
+    if (!regionChunk.nonNegative() || regionChunk.i >= c_LightingRegionSize || regionChunk.j >= c_LightingRegionSize || regionChunk.k >= c_LightingRegionSize)
+      return false;
+    return dirtyChunks[dirtyChunkSlot(regionChunk)];
+  };
 
-  // Perform initial propogation of sunlight downward until light hits opaque block
-  BlockArrayRect<blockIndex_t> attenuatedSunlightExtents(Chunk::Bounds2D(), Chunk::Size());
-  for (const BlockIndex& blockIndex : BlockData::Bounds().faceInterior(eng::math::Direction::Top))
+  BlockBox regionBounds = BlockBox::VoidBox();
+  for (const std::shared_ptr<Chunk>& chunk : chunks)
   {
-    BlockIndex propogationIndex = blockIndex;
-    if (blockData.lighting(propogationIndex) != block::Light::MaxValue())
-      continue;
+    dirtyChunks[dirtyChunkSlot((chunk->globalIndex() - regionOrigin).checkedCast<localIndex_t>())] = true;
+    regionBounds.expandToEnclose(Chunk::Bounds() + chunkOffset(chunk->globalIndex()));
+  }
+  regionBounds.expand();
 
-    for (propogationIndex.k = blockIndex.k - 1; propogationIndex.k >= Chunk::Bounds().min.k; --propogationIndex.k)
+  // Chunks outside of the batch are not relit, so only the faces bordering them are needed as light sources
+  std::vector<BlockBox> borderFaces;
+  for (const std::shared_ptr<Chunk>& chunk : chunks)
+    for (eng::math::Direction direction : eng::math::Directions())
     {
-      if (!blockData.composition(propogationIndex).hasTransparency())
-        break;
-      blockData.lighting(propogationIndex) = block::Light::MaxValue();
+      BlockBox borderFace = BlockData::Bounds().faceInterior(direction) + chunkOffset(chunk->globalIndex());
+      if (!isDirty(borderFace.min))
+        borderFaces.push_back(borderFace);
     }
 
-    blockIndex_t i = propogationIndex.i;
-    blockIndex_t j = propogationIndex.j;
-    blockIndex_t k = propogationIndex.k + 1;
-
-    if (j - 1 > 0)
-      attenuatedSunlightExtents[i][j - 1] = std::min(attenuatedSunlightExtents[i][j - 1], k);
-    if (j + 1 < Chunk::Size())
-      attenuatedSunlightExtents[i][j + 1] = std::min(attenuatedSunlightExtents[i][j + 1], k);
-    if (i - 1 > 0)
-      attenuatedSunlightExtents[i - 1][j] = std::min(attenuatedSunlightExtents[i - 1][j], k);
-    if (i + 1 < Chunk::Size())
-      attenuatedSunlightExtents[i + 1][j] = std::min(attenuatedSunlightExtents[i + 1][j], k);
-  }
+  // Lighting edits made to the batch while it is being solved are overwritten when the results are committed, so any
+  // chunk that was edited in the meantime is relit afterwards
+  std::unordered_map<GlobalIndex, std::optional<u32>> lightingVersions;
+  for (const std::shared_ptr<Chunk>& chunk : chunks)
+    lightingVersions.emplace(chunk->globalIndex(), chunk->lightingVersion());
+
+  BlockArrayBox<block::Type> composition = m_ChunkContainer.retrieveTypeData(regionOrigin, { regionBounds });
+  BlockArrayBox<block::Light> lighting = m_ChunkContainer.retrieveLightingData(regionOrigin, borderFaces);
+
+  std::array<std::vector<BlockIndex>, block::Light::MaxValue() + 1>& lightQueues = tl_Scratch.lightQueues;
+  for (std::vector<BlockIndex>& propogationQueue : lightQueues)
+    propogationQueue.clear();
 
-  // Light unlit blocks neighboring sunlight with attenuated sunlight value and add them to the propogation stack
-  std::array<std::stack<BlockIndex>, block::Light::MaxValue() + 1> sunlight;
-  attenuatedSunlightExtents.forEach([&blockData, &sunlight](const BlockIndex2D& index, blockIndex_t k)
+  for (const std::shared_ptr<Chunk>& chunk : chunks)
   {
-    static constexpr i8 attenuatedIntensity = block::Light::MaxValue() - attenuation;
-    for (BlockIndex blockIndex(index, k); blockIndex.k < Chunk::Size(); ++blockIndex.k)
+    BlockIndex offset = chunkOffset(chunk->globalIndex());
+
+    // Sunlight travels straight down through sky-exposed columns until it hits the topmost opaque block
+    BlockArrayRect<blockIndex_t> attenuatedSunlightExtents(Chunk::Bounds2D(), Chunk::Size());
+    for (const BlockIndex2D& column : Chunk::Bounds2D())
     {
-      if (!blockData.composition(blockIndex).hasTransparency() || blockData.lighting(blockIndex) == block::Light::MaxValue())
+      if (!chunk->isSkyExposed(column))
         continue;
 
-      blockData.lighting(blockIndex) = attenuatedIntensity;
-      sunlight[attenuatedIntensity].push(blockIndex);
+      blockIndex_t i = column.i;
+      blockIndex_t j = column.j;
+      blockIndex_t k = chunk->topOpaqueBlock(column) + 1;
+      for (BlockIndex blockIndex(column, k); blockIndex.k < Chunk::Size(); ++blockIndex.k)
+        lighting(blockIndex + offset) = block::Light(block::Light::MaxValue());
+
+      if (j - 1 > 0)
+        attenuatedSunlightExtents[i][j - 1] = std::min(attenuatedSunlightExtents[i][j - 1], k);
+      if (j + 1 < Chunk::Size())
+        attenuatedSunlightExtents[i][j + 1] = std::min(attenuatedSunlightExtents[i][j + 1], k);
+      if (i - 1 > 0)
+        attenuatedSunlightExtents[i - 1][j] = std::min(attenuatedSunlightExtents[i - 1][j], k);
+      if (i + 1 < Chunk::Size())
+        attenuatedSunlightExtents[i + 1][j] = std::min(attenuatedSunlightExtents[i + 1][j], k);
     }
-  });
 
-  // Add lit blocks in neighboring chunk to propogation stack
-  for (eng::math::Direction direction : eng::math::Directions())
-  {
-    // Top neighbors already accounted for
-    if (direction == eng::math::Direction::Top)
-      continue;
+    // Light unlit blocks neighboring sunlight with attenuated sunlight value and add them to the propogation stack.
+    // Propagation queues are bucketed by the brighter of the two light channels.
+    attenuatedSunlightExtents.forEach([&composition, &lighting, &lightQueues, &offset](const BlockIndex2D& index, blockIndex_t k)
+    {
+      static constexpr i8 attenuatedIntensity = block::Light::MaxValue() - attenuation;
+      for (BlockIndex blockIndex = BlockIndex(index, k) + offset; blockIndex.k < Chunk::Size() + offset.k; ++blockIndex.k)
+      {
+        if (!composition(blockIndex).hasTransparency() || lighting(blockIndex).sunlight() == block::Light::MaxValue())
+          continue;
 
-    for (const BlockIndex& blockIndex : BlockData::Bounds().faceInterior(direction))
-      if (blockData.composition(blockIndex).hasTransparency())
-        sunlight[blockData.lighting(blockIndex).sunlight()].push(blockIndex);
+        lighting(blockIndex) = block::Light(attenuatedIntensity);
+        lightQueues[attenuatedIntensity].push_back(blockIndex);
+      }
+    });
+
+    // Light-emitting blocks are sources of block light
+    for (const BlockIndex& blockIndex : Chunk::Bounds() + offset)
+    {
+      i8 emission = composition(blockIndex).lightEmission();
+      if (emission == 0)
+        continue;
+
+      block::Light& blockLight = lighting(blockIndex);
+      blockLight = block::Light(blockLight.sunlight(), emission);
+      lightQueues[blockLight.intensity()].push_back(blockIndex);
+    }
   }
 
-  // Propogate attenuated sunlight
+  // Add lit blocks in neighboring chunks to propogation stack. Sunlight from top neighbors has already been
+  // accounted for, but they may still carry block light.
+  for (const BlockBox& borderFace : borderFaces)
+    for (const BlockIndex& blockIndex : borderFace)
+      if (composition(blockIndex).hasTransparency())
+        lightQueues[lighting(blockIndex).intensity()].push_back(blockIndex);
+
+  // Propogate both light channels at once, crossing freely between chunks of the batch. Channels raised in a neighbor
+  // are never brighter than the propagated light, so the neighbor never lands in a bucket that has already been processed.
   for (i8 intensity = block::Light::MaxValue(); intensity > 0; --intensity)
-    while (!sunlight[intensity].empty())
+    while (!lightQueues[intensity].empty())
     {
-      BlockIndex lightIndex = sunlight[intensity].top();
-      sunlight[intensity].pop();
+      BlockIndex lightIndex = lightQueues[intensity].back();
+      lightQueues[intensity].pop_back();
 
+      block::Light light = lighting(lightIndex);
       for (eng::math::Direction direction : eng::math::Directions())
       {
         BlockIndex lightNeighbor = lightIndex + BlockIndex::Dir(direction);
-        if (!Chunk::Bounds().encloses(lightNeighbor) || !blockData.composition(lightNeighbor).hasTransparency())
+        if (!isDirty(lightNeighbor) || !composition(lightNeighbor).hasTransparency())
           continue;
 
-        i8 neighborIntensity = intensity - attenuation;
-        if (neighborIntensity <= blockData.lighting(lightNeighbor).sunlight())
+        block::Light propagatedLight = light.propagated(direction);
+        block::Light raisedLight = block::Light::Max(lighting(lightNeighbor), propagatedLight);
+        if (raisedLight == lighting(lightNeighbor))
           continue;
 
-        blockData.lighting(lightNeighbor) = neighborIntensity;
-        sunlight[neighborIntensity].push(lightNeighbor);
+        lighting(lightNeighbor) = raisedLight;
+        lightQueues[propagatedLight.intensity()].push_back(lightNeighbor);
       }
     }
 
-  BlockArrayBox<block::Light> newLighting(Chunk::Bounds(), eng::AllocationPolicy::Deferred);
-  if (blockData.lighting.anyOf(Chunk::Bounds(), [](block::Light blockLight) { return blockLight != block::Light::MaxValue(); }))
+  // Commit results and compare lighting on the outer faces of the batch. Light that increased is spread into
+  // neighboring chunks directly, while light that decreased requires the chunk on the other side to be relit in full.
+  std::vector<std::pair<GlobalIndex, BlockIndex>> brightenedBlocks;
+  std::unordered_set<GlobalIndex> darkenedNeighbors;
+  std::unordered_map<GlobalIndex, u64> meshUpdates;
+  std::vector<GlobalIndex> editedChunks;
+  auto markChanged = [&meshUpdates](const GlobalIndex& chunkIndex, const BlockIndex& blockIndex)
   {
-    newLighting.allocate();
-    newLighting.fill(Chunk::Bounds(), blockData.lighting, Chunk::Bounds(), block::Light::MaxValue());
+    for (const LocalIndex& localIndex : affectedChunks(blockIndex))
+      meshUpdates[chunkIndex + localIndex.upcast<globalIndex_t>()] |= affectedSections(blockIndex - Chunk::Size() * localIndex.checkedCast<blockIndex_t>());
+  };
+  for (const std::shared_ptr<Chunk>& chunk : chunks)
+  {
+    const GlobalIndex& chunkIndex = chunk->globalIndex();
+    BlockIndex offset = chunkOffset(chunkIndex);
+
+    BlockArrayBox<block::Light> newLighting(Chunk::Bounds(), eng::AllocationPolicy::Deferred);
+    if (lighting.anyOf(Chunk::Bounds() + offset, [](block::Light blockLight) { return blockLight != block::Light(block::Light::MaxValue()); }))
+    {
+      newLighting.allocate();
+      newLighting.fill(Chunk::Bounds(), lighting, Chunk::Bounds() + offset, block::Light(block::Light::MaxValue()));
+    }
+
+    chunk->lighting().readOperation([&chunkIndex, &offset, &isDirty, &newLighting, &brightenedBlocks, &darkenedNeighbors, &markChanged](const BlockArrayBox<block::Light>& lighting, const block::Light& defaultValue)
+    {
+      // Only the sections around blocks whose light changed need to be re-meshed
+      if (lighting || newLighting || defaultValue != block::Light(block::Light::MaxValue()))
+        for (const BlockIndex& blockIndex : Chunk::Bounds())
+        {
+          block::Light oldLight = lighting ? lighting(blockIndex) : defaultValue;
+          block::Light newLight = newLighting ? newLighting(blockIndex) : block::Light(block::Light::MaxValue());
+          if (newLight != oldLight)
+            markChanged(chunkIndex, blockIndex);
+        }
+
+      for (eng::math::Direction direction : eng::math::Directions())
+      {
+        // Faces shared with other chunks of the batch have already been solved
+        if (isDirty(offset + BlockData::Bounds().faceInterior(direction).min))
+          continue;
+
+        for (const BlockIndex& blockIndex : Chunk::Bounds().face(direction))
+        {
+          block::Light oldLight = lighting ? lighting(blockIndex) : defaultValue;
+          block::Light newLight = newLighting ? newLighting(blockIndex) : block::Light(block::Light::MaxValue());
+          if (newLight == oldLight)
+            continue;
+
+          // A block can brighten in one channel while darkening in the other
+          if (block::Light::Max(oldLight, newLight) != oldLight)
+            brightenedBlocks.emplace_back(chunkIndex, blockIndex);
+          if (block::Light::Max(oldLight, newLight) != newLight)
+            darkenedNeighbors.insert(chunkIndex + GlobalIndex::Dir(direction));
+        }
+      }
+    });
+
+    chunk->setLighting(std::move(newLighting));
+
+    std::optional<u32> lightingVersion = lightingVersions.at(chunkIndex);
+    if (!lightingVersion || chunk->lightingVersion() != lightingVersion)
+      editedChunks.push_back(chunkIndex);
   }
 
-  std::unordered_set<GlobalIndex> additionalLightingUpdates;
-  chunk.lighting().readOperation([&chunkIndex, &newLighting, &additionalLightingUpdates](const BlockArrayBox<block::Light>& lighting, const block::Light& defaultValue)
-  {
-    static constexpr std::array<BlockBox, 26> chunkDecomposition = decomposeBlockBoxBoundary(Chunk::Bounds());
-    for (const BlockBox& chunkSection : chunkDecomposition)
-      if (!lighting.contentsEqual(chunkSection, newLighting, chunkSection, defaultValue))
-        for (const LocalIndex& localIndex : affectedChunks(chunkSection))
-          additionalLightingUpdates.insert(chunkIndex + localIndex.upcast<globalIndex_t>());
-  });
+  // Light is spread outward once the entire batch has been committed, since it may pass through several chunks of the batch
+  LightPropagator lightPropagator(m_ChunkContainer.chunks());
+  for (const auto& [chunkIndex, blockIndex] : brightenedBlocks)
+    lightPropagator.addSource(chunkIndex, blockIndex);
+  lightPropagator.propagate();
+  for (const auto& [updateIndex, sectionMask] : lightPropagator.affectedSections())
+    meshUpdates[updateIndex] |= sectionMask;
 
-  chunk.setLighting(std::move(newLighting));
+  // Chunks that are lit for the first time have not been meshed yet
+  for (const std::shared_ptr<Chunk>& chunk : chunks)
+    if (chunk->advanceState(Chunk::State::Ready, Chunk::State::Lit))
+      meshUpdates[chunk->globalIndex()] = Chunk::AllSections();
 
-  additionalLightingUpdates.erase(chunkIndex);
-  for (const GlobalIndex& updateIndex : additionalLightingUpdates)
+  for (const GlobalIndex& updateIndex : darkenedNeighbors)
     addToLightingUpdateQueue(updateIndex);
-
-  addToLazyMeshUpdateQueue(chunkIndex);
+  for (const GlobalIndex& updateIndex : editedChunks)
+    addToLightingUpdateQueue(updateIndex);
+  for (const auto& [updateIndex, sectionMask] : meshUpdates)
+    addToLazyMeshUpdateQueue(updateIndex, sectionMask);
 }
 
-void ChunkManager::lightingTask(const GlobalIndex& chunkIndex)
+void ChunkManager::lightingTask(const GlobalIndex& regionIndex)
 {
-  if (m_ChunkContainer.hasBoundaryNeighbors(chunkIndex))
-    return;
+  std::unordered_set<GlobalIndex> dirtyIndices;
+  {
+    std::lock_guard lock(m_DirtyLightingMutex);
 
-  std::shared_ptr<Chunk> chunk = m_ChunkContainer.chunks().get(chunkIndex);
-  if (!chunk)
-    return;
+    auto nodeHandle = m_DirtyLighting.extract(regionIndex);
+    if (nodeHandle.empty())
+      return;
+    dirtyIndices = std::move(nodeHandle.mapped());
+  }
+
+  // Chunks that are not ready yet will be lit once their neighbors have loaded
+  std::vector<std::shared_ptr<Chunk>> chunks;
+  for (const GlobalIndex& chunkIndex : dirtyIndices)
+  {
+    std::shared_ptr<Chunk> chunk = m_ChunkContainer.chunks().get(chunkIndex);
+    if (chunk && chunk->state() != Chunk::State::Generated)
+      chunks.push_back(std::move(chunk));
+  }
 
-  updateLighting(*chunk);
+  if (!chunks.empty())
+    updateLighting(regionIndex, chunks);
 }
 
 void ChunkManager::lazyMeshingTask(const GlobalIndex& chunkIndex)
 {
-  if (m_ChunkContainer.hasBoundaryNeighbors(chunkIndex))
-    return;
+  u64 sectionMask = 0;
+  {
+    std::lock_guard lock(m_PendingMeshingMutex);
+
+    auto nodeHandle = m_PendingMeshing.extract(chunkIndex);
+    if (nodeHandle.empty())
+      return;
+    sectionMask = nodeHandle.mapped();
+  }
 
   std::shared_ptr<Chunk> chunk = m_ChunkContainer.chunks().get(chunkIndex);
-  if (!chunk)
+  if (!chunk || chunk->state() < Chunk::State::Lit)
     return;
 
-  meshChunk(*chunk);
+  if (chunk->state() != Chunk::State::Meshed)
+    sectionMask = Chunk::AllSections();
+  meshChunk(*chunk, sectionMask);
   chunk->update();
+  chunk->advanceState(Chunk::State::Lit, Chunk::State::Meshed);
 }
 
-void ChunkManager::forceMeshingTask(const GlobalIndex& chunkIndex)
+void ChunkManager::forceMeshingTask(const ChunkSectionID& sectionID)
 {
-  std::shared_ptr<Chunk> chunk = m_ChunkContainer.chunks().get(chunkIndex);
+  std::shared_ptr<Chunk> chunk = m_ChunkContainer.chunks().get(sectionID.chunkIndex);
+  if (!chunk && m_ChunkContainer.isKnownEmpty(sectionID.chunkIndex))
+    return;
   if (!chunk)
-    chunk = generateNewChunk(chunkIndex);
+    chunk = generateNewChunk(sectionID.chunkIndex);
 
-  meshChunk(*chunk);
+  meshChunk(*chunk, eng::u64Bit(sectionID.section));
   chunk->update();
 }
\ No newline at end of file
@@ -14,11 +14,19 @@ class ChunkManager
   eng::thread::WorkSet<GlobalIndex, void> m_CleanWork;
   eng::thread::WorkSet<GlobalIndex, void> m_LightingWork;
   eng::thread::WorkSet<GlobalIndex, void> m_LazyMeshingWork;
-  eng::thread::WorkSet<GlobalIndex, void> m_ForceMeshingWork;
+  eng::thread::WorkSet<ChunkSectionID, void> m_ForceMeshingWork;
 
   // Chunk data
   ChunkContainer m_ChunkContainer;
 
+  // Chunks waiting to be lit, grouped by lighting region
+  std::mutex m_DirtyLightingMutex;
+  std::unordered_map<GlobalIndex, std::unordered_set<GlobalIndex>> m_DirtyLighting;
+
+  // Sections waiting to be lazily re-meshed, as a bit mask of sections for each chunk
+  std::mutex m_PendingMeshingMutex;
+  std::unordered_map<GlobalIndex, u64> m_PendingMeshing;
+
 public:
   ChunkManager();
   ~ChunkManager();
@@ -45,32 +53,64 @@ public:
   void placeBlock(GlobalIndex chunkIndex, BlockIndex blockIndex, eng::math::Direction face, block::Type blockType);
   void removeBlock(const GlobalIndex& chunkIndex, const BlockIndex& blockIndex);
 
+  /*
+    Times the per-face and per-plane vertex lighting methods on the chunk the player is in and logs the results.
+    Also checks that all methods produce identical lighting.
+  */
+  void benchmarkFaceLighting() const;
+
 private:
+  /*
+    Schedules the first lighting and meshing pass of a generated chunk. Chunks are only
+    scheduled once, regardless of how many times this is called.
+  */
+  void markReady(const GlobalIndex& chunkIndex);
+
+  /*
+    Marks a chunk as needing its lighting recalculated. Dirty chunks are grouped by lighting region,
+    and all dirty chunks of a region are lit together by a single task.
+  */
   void addToLightingUpdateQueue(const GlobalIndex& chunkIndex);
-  void addToLazyMeshUpdateQueue(const GlobalIndex& chunkIndex);
-  void addToForceMeshUpdateQueue(const GlobalIndex& chunkIndex);
+
+  /*
+    Marks sections of a chunk as needing to be re-meshed. Sections marked before the chunk's meshing task
+    runs are re-meshed together. A chunk that has not been meshed yet is always meshed in full.
+  */
+  void addToLazyMeshUpdateQueue(const GlobalIndex& chunkIndex, u64 sectionMask = Chunk::AllSections());
+  void addToForceMeshUpdateQueue(const ChunkSectionID& sectionID);
   void removeMeshes(const GlobalIndex& chunkIndex);
 
+  /*
+    Generates the chunk at the given index, unless it is known to be empty.
+    \returns The generated chunk, or nullptr if it was recorded as known empty.
+  */
+  std::shared_ptr<Chunk> loadChunk(const GlobalIndex& chunkIndex);
   std::shared_ptr<Chunk> generateNewChunk(const GlobalIndex& chunkIndex);
   void eraseChunk(const GlobalIndex& chunkIndex);
 
   /*
     Queues chunk where the block update occured for updating. If specified block is on chunk border,
-    will also update neighboring chunks. Chunk and its face neighbors are queue for an immediate update,
-    while edge and corner neighbors are queued for later.
+    will also update neighboring chunks. Sections of the chunk and its face neighbors that the update
+    can reach are queued for an immediate update, while edge and corner neighbors are queued for later.
   */
   void sendBlockUpdate(const GlobalIndex& chunkIndex, const BlockIndex& blockIndex);
 
   /*
     Generates simplistic mesh in a compressed format based on chunk compostion.
     Block faces covered by opaque blocks will not be added to mesh.
+    Each chunk section is given its own draw command, and only sections in the mask are re-meshed.
     Uses AO algorithm outlined in https://0fps.net/2013/07/03/ambient-occlusion-for-minecraft-like-worlds/
   */
-  void meshChunk(const Chunk& chunk);
+  void meshChunk(const Chunk& chunk, u64 sectionMask = Chunk::AllSections());
 
-  void updateLighting(Chunk& chunk);
+  /*
+    Relights the given chunks of a lighting region in a single pass over a shared buffer. Light is solved across
+    the borders between the given chunks directly, while chunks outside of the batch only act as light sources.
+    Changes along the outer border of the batch are then spread into neighboring chunks.
+  */
+  void updateLighting(const GlobalIndex& regionIndex, const std::vector<std::shared_ptr<Chunk>>& chunks);
 
-  void lightingTask(const GlobalIndex& chunkIndex);
+  void lightingTask(const GlobalIndex& regionIndex);
   void lazyMeshingTask(const GlobalIndex& chunkIndex);
-  void forceMeshingTask(const GlobalIndex& chunkIndex);
+  void forceMeshingTask(const ChunkSectionID& sectionID);
 };
\ No newline at end of file
@@ -0,0 +1,176 @@
+#include "GMpch.h"
+#include "FaceLighting.h"
+#include "ChunkHelpers.h"
+#include "Engine/Core/Simd.h"
+
+#if defined(ENG_SIMD_SSE2)
+static __m128i loadBytes(const u8* address)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(address));
+}
+
+/*
+  \returns The sums of 16 consecutive 2x2 windows of bytes, the first of which starts at the given address.
+*/
+static __m128i windowSums(const u8* address, i32 rowStride)
+{
+  __m128i upperRow = _mm_add_epi8(loadBytes(address), loadBytes(address + 1));
+  __m128i lowerRow = _mm_add_epi8(loadBytes(address + rowStride), loadBytes(address + rowStride + 1));
+  return _mm_add_epi8(upperRow, lowerRow);
+}
+
+/*
+  Divides unsigned bytes, rounding down. Quotients of values this small are exact in single precision,
+  so truncating the result of a floating-point division gives the correct integer quotient.
+*/
+static __m128i divideBytes(__m128i dividends, __m128i divisors)
+{
+  __m128i zero = _mm_setzero_si128();
+  auto divideWords = [zero](__m128i dividendWords, __m128i divisorWords)
+  {
+    __m128 lowQuotients = _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(dividendWords, zero)), _mm_cvtepi32_ps(_mm_unpacklo_epi16(divisorWords, zero)));
+    __m128 highQuotients = _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(dividendWords, zero)), _mm_cvtepi32_ps(_mm_unpackhi_epi16(divisorWords, zero)));
+    return _mm_packs_epi32(_mm_cvttps_epi32(lowQuotients), _mm_cvttps_epi32(highQuotients));
+  };
+
+  __m128i lowQuotients = divideWords(_mm_unpacklo_epi8(dividends, zero), _mm_unpacklo_epi8(divisors, zero));
+  __m128i highQuotients = divideWords(_mm_unpackhi_epi8(dividends, zero), _mm_unpackhi_epi8(divisors, zero));
+  return _mm_packus_epi16(lowQuotients, highQuotients);
+}
+#endif
+
+
+
+FaceLightingPlane::FaceLightingPlane()
+  : m_Sunlight{},
+    m_BlockLight{},
+    m_AmbientOcclusion{},
+    m_Face(eng::math::Direction::First) {}
+
+void FaceLightingPlane::calculate(const BlockArrayBox<block::Type>& composition, const BlockArrayBox<block::Light>& lighting,
+                                  const BlockBox& sectionBounds, eng::math::Direction face, blockIndex_t layer, bool useSimd)
+{
+  eng::math::Axis normalAxis = axisOf(face);
+  const std::array<eng::math::Axis, 2>& quadAxes = ChunkVertex::GetQuadAxes(face);
+  blockIndex_t neighborLayer = layer + (isUpstream(face) ? 1 : -1);
+
+  m_Face = face;
+  m_Anchor = BlockIndex2D(sectionBounds.min[quadAxes[0]], sectionBounds.min[quadAxes[1]]);
+
+  // Each vertex of a face is lit by the transparent blocks among the 8 blocks that surround it, which lie in the
+  // layer of the face and the layer in front of it. Sum these layers together, so that only 2x2 windows remain.
+  alignas(16) Plane transparentBlocks{};
+  alignas(16) Plane transparentSunlight{};
+  alignas(16) Plane transparentBlockLight{};
+  alignas(16) Plane opaqueNeighbors{};
+  for (i32 row = 0; row < c_RowLength; ++row)
+    for (i32 column = 0; column < c_RowLength; ++column)
+    {
+      i32 planeIndex = c_RowStride * row + column;
+
+      BlockIndex blockIndex;
+      blockIndex[quadAxes[0]] = eng::arithmeticCastUnchecked<blockIndex_t>(m_Anchor.i - 1 + row);
+      blockIndex[quadAxes[1]] = eng::arithmeticCastUnchecked<blockIndex_t>(m_Anchor.j - 1 + column);
+      for (blockIndex_t blockLayer : { layer, neighborLayer })
+      {
+        blockIndex[normalAxis] = blockLayer;
+        if (composition(blockIndex).hasTransparency())
+        {
+          block::Light blockLight = lighting(blockIndex);
+          transparentBlocks[planeIndex]++;
+          transparentSunlight[planeIndex] += eng::arithmeticCastUnchecked<u8>(blockLight.sunlight());
+          transparentBlockLight[planeIndex] += eng::arithmeticCastUnchecked<u8>(blockLight.blockLight());
+        }
+        else if (blockLayer == neighborLayer)
+          opaqueNeighbors[planeIndex] = 1;
+      }
+    }
+
+  i32 firstScalarColumn = 0;
+#if defined(ENG_SIMD_SSE2)
+  if (useSimd)
+  {
+    __m128i one = _mm_set1_epi8(1);
+    __m128i maxAmbientOcclusion = _mm_set1_epi8(3);
+    for (i32 vertexRow = 0; vertexRow < c_VerticesPerRow; ++vertexRow)
+      for (i32 vertexColumn = 0; vertexColumn < c_VerticesPerRow; vertexColumn += 16)
+      {
+        i32 planeIndex = c_RowStride * vertexRow + vertexColumn;
+
+        __m128i blockCounts = _mm_max_epu8(windowSums(&transparentBlocks[planeIndex], c_RowStride), one);
+        __m128i totalSunlight = windowSums(&transparentSunlight[planeIndex], c_RowStride);
+        __m128i totalBlockLight = windowSums(&transparentBlockLight[planeIndex], c_RowStride);
+        _mm_store_si128(reinterpret_cast<__m128i*>(&m_Sunlight[planeIndex]), divideBytes(totalSunlight, blockCounts));
+        _mm_store_si128(reinterpret_cast<__m128i*>(&m_BlockLight[planeIndex]), divideBytes(totalBlockLight, blockCounts));
+
+        // Two opaque blocks on one diagonal of the window fully occlude the vertex
+        __m128i opaque00 = loadBytes(&opaqueNeighbors[planeIndex]);
+        __m128i opaque01 = loadBytes(&opaqueNeighbors[planeIndex + 1]);
+        __m128i opaque10 = loadBytes(&opaqueNeighbors[planeIndex + c_RowStride]);
+        __m128i opaque11 = loadBytes(&opaqueNeighbors[planeIndex + c_RowStride + 1]);
+        __m128i diagonalA = _mm_andnot_si128(_mm_or_si128(opaque01, opaque10), _mm_and_si128(opaque00, opaque11));
+        __m128i diagonalB = _mm_andnot_si128(_mm_or_si128(opaque00, opaque11), _mm_and_si128(opaque01, opaque10));
+        __m128i opaqueCount = _mm_add_epi8(_mm_add_epi8(opaque00, opaque01), _mm_add_epi8(opaque10, opaque11));
+        __m128i ambientOcclusion = _mm_min_epu8(_mm_add_epi8(opaqueCount, _mm_or_si128(diagonalA, diagonalB)), maxAmbientOcclusion);
+        _mm_store_si128(reinterpret_cast<__m128i*>(&m_AmbientOcclusion[planeIndex]), ambientOcclusion);
+      }
+    firstScalarColumn = c_VerticesPerRow;
+  }
+#endif
+
+  // Scalar fallback, using the same formulation as the vectorized path
+  for (i32 vertexRow = 0; vertexRow < c_VerticesPerRow; ++vertexRow)
+    for (i32 vertexColumn = firstScalarColumn; vertexColumn < c_VerticesPerRow; ++vertexColumn)
+    {
+      std::array<i32, 4> windowIndices = { c_RowStride * vertexRow + vertexColumn,     c_RowStride * vertexRow + vertexColumn + 1,
+                                           c_RowStride * (vertexRow + 1) + vertexColumn, c_RowStride * (vertexRow + 1) + vertexColumn + 1 };
+      auto windowSum = [&windowIndices](const Plane& plane)
+      {
+        return eng::algo::accumulate(windowIndices, 0, [&plane](i32 sum, i32 index) { return sum + plane[index]; });
+      };
+
+      i32 planeIndex = windowIndices[0];
+      i32 blockCount = std::max(windowSum(transparentBlocks), 1);
+      m_Sunlight[planeIndex] = eng::arithmeticCastUnchecked<u8>(windowSum(transparentSunlight) / blockCount);
+      m_BlockLight[planeIndex] = eng::arithmeticCastUnchecked<u8>(windowSum(transparentBlockLight) / blockCount);
+
+      bool opaque00 = opaqueNeighbors[windowIndices[0]];
+      bool opaque01 = opaqueNeighbors[windowIndices[1]];
+      bool opaque10 = opaqueNeighbors[windowIndices[2]];
+      bool opaque11 = opaqueNeighbors[windowIndices[3]];
+      bool diagonal = (opaque00 && opaque11 && !opaque01 && !opaque10) || (opaque01 && opaque10 && !opaque00 && !opaque11);
+      m_AmbientOcclusion[planeIndex] = eng::arithmeticCastUnchecked<u8>(std::min(windowSum(opaqueNeighbors) + diagonal, 3));
+    }
+}
+
+std::array<i32, 4> FaceLightingPlane::sunlight(const BlockIndex& blockIndex) const
+{
+  return vertexValues(m_Sunlight, blockIndex);
+}
+
+std::array<i32, 4> FaceLightingPlane::blockLight(const BlockIndex& blockIndex) const
+{
+  return vertexValues(m_BlockLight, blockIndex);
+}
+
+std::array<i32, 4> FaceLightingPlane::ambientOcclusion(const BlockIndex& blockIndex) const
+{
+  return vertexValues(m_AmbientOcclusion, blockIndex);
+}
+
+std::array<i32, 4> FaceLightingPlane::vertexValues(const Plane& plane, const BlockIndex& blockIndex) const
+{
+  const std::array<eng::math::Axis, 2>& quadAxes = ChunkVertex::GetQuadAxes(m_Face);
+
+  std::array<i32, 4> values{};
+  for (i32 quadIndex = 0; quadIndex < 4; ++quadIndex)
+  {
+    BlockIndex vertexPosition = blockIndex + ChunkVertex::GetOffset(m_Face, quadIndex);
+    i32 vertexRow = vertexPosition[quadAxes[0]] - m_Anchor.i;
+    i32 vertexColumn = vertexPosition[quadAxes[1]] - m_Anchor.j;
+    ENG_ASSERT(eng::withinBounds(vertexRow, 0, c_VerticesPerRow) && eng::withinBounds(vertexColumn, 0, c_VerticesPerRow), "Block is outside of lighting plane!");
+
+    values[quadIndex] = plane[c_RowStride * vertexRow + vertexColumn];
+  }
+  return values;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include "Chunk.h"
+
+/*
+  Per-vertex sunlight, block light and ambient occlusion of the faces of a single layer of blocks within a chunk section,
+  all pointing in the same direction. Values are computed for every vertex of the layer at once, by summing
+  2x2 windows over rows of precomputed transparency and light values. Rows are processed with SIMD if available.
+
+  The ambient occlusion of a vertex only depends on the four blocks in front of it, given that the block in
+  front of the face itself is transparent. Hence, results are only valid for faces of opaque blocks.
+*/
+class FaceLightingPlane
+{
+  static constexpr i32 c_RowLength = Chunk::SectionSize() + 2;        // Blocks per row, including a block of padding on either side
+  static constexpr i32 c_VerticesPerRow = Chunk::SectionSize() + 1;
+  static constexpr i32 c_RowStride = 16 * ((c_RowLength + 15) / 16);
+  static constexpr i32 c_PlaneSize = c_RowLength * c_RowStride + 16;  // Extra padding so that unaligned loads of the last row stay in bounds
+
+public:
+  using Plane = std::array<u8, c_PlaneSize>;
+
+private:
+  alignas(16) Plane m_Sunlight;
+  alignas(16) Plane m_BlockLight;
+  alignas(16) Plane m_AmbientOcclusion;
+  eng::math::Direction m_Face;
+  BlockIndex2D m_Anchor;
+
+public:
+  FaceLightingPlane();
+
+  /*
+    Computes lighting for all faces pointing in the given direction whose blocks lie in the given layer of the section.
+    The composition and lighting must cover the section padded by one block in every direction.
+  */
+  void calculate(const BlockArrayBox<block::Type>& composition, const BlockArrayBox<block::Light>& lighting,
+                 const BlockBox& sectionBounds, eng::math::Direction face, blockIndex_t layer, bool useSimd = true);
+
+  std::array<i32, 4> sunlight(const BlockIndex& blockIndex) const;
+  std::array<i32, 4> blockLight(const BlockIndex& blockIndex) const;
+  std::array<i32, 4> ambientOcclusion(const BlockIndex& blockIndex) const;
+
+private:
+  std::array<i32, 4> vertexValues(const Plane& plane, const BlockIndex& blockIndex) const;
+};
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "GMpch.h"
+#include "LightPropagation.h"
+#include "Indexing/Operations.h"
+
+LightPropagator::LightPropagator(const eng::thread::UnorderedMap<GlobalIndex, Chunk>& chunks)
+  : m_Chunks(chunks) {}
+
+LightPropagator::~LightPropagator()
+{
+  for (const auto& [chunkIndex, chunk] : m_ChunkCache)
+    if (chunk)
+      chunk->endLightingEdit();
+}
+
+void LightPropagator::addSource(const GlobalIndex& chunkIndex, const BlockIndex& blockIndex)
+{
+  Chunk* chunk = getChunk(chunkIndex);
+  if (!chunk)
+    return;
+
+  i8 intensity = chunk->lighting().get(blockIndex).intensity();
+  if (intensity > c_Attenuation)
+    m_Queues[intensity].push_back({ chunkIndex, blockIndex });
+}
+
+void LightPropagator::addNeighborsAsSources(const GlobalIndex& chunkIndex, const BlockIndex& blockIndex)
+{
+  for (eng::math::Direction direction : eng::math::Directions())
+  {
+    LightNode neighbor = Neighbor({ chunkIndex, blockIndex }, direction);
+    addSource(neighbor.chunkIndex, neighbor.blockIndex);
+  }
+}
+
+void LightPropagator::addEmitter(const GlobalIndex& chunkIndex, const BlockIndex& blockIndex)
+{
+  Chunk* chunk = getChunk(chunkIndex);
+  if (!chunk)
+    return;
+
+  i8 emission = chunk->composition().get(blockIndex).lightEmission();
+  if (RaiseLight(*chunk, blockIndex, block::Light(0, emission)))
+    markAffected({ chunkIndex, blockIndex });
+  addSource(chunkIndex, blockIndex);
+}
+
+void LightPropagator::removeSource(const GlobalIndex& chunkIndex, const BlockIndex& blockIndex)
+{
+  Chunk* chunk = getChunk(chunkIndex);
+  if (!chunk)
+    return;
+
+  i8 emission = chunk->composition().get(blockIndex).lightEmission();
+  block::Light removedLight = chunk->lighting().replace(blockIndex, block::Light(0, emission));
+  if (removedLight != block::Light())
+  {
+    m_RemovalQueue.push_back({ { chunkIndex, blockIndex }, removedLight });
+    markAffected({ chunkIndex, blockIndex });
+  }
+  if (emission > 0)
+    addSource(chunkIndex, blockIndex);
+}
+
+void LightPropagator::propagate()
+{
+  ENG_PROFILE_FUNCTION();
+
+  removeLight();
+
+  for (i8 intensity = block::Light::MaxValue(); intensity > c_Attenuation; --intensity)
+    while (!m_Queues[intensity].empty())
+    {
+      LightNode lightNode = m_Queues[intensity].back();
+      m_Queues[intensity].pop_back();
+
+      block::Light light = getChunk(lightNode.chunkIndex)->lighting().get(lightNode.blockIndex);
+      for (eng::math::Direction direction : eng::math::Directions())
+      {
+        LightNode neighbor = Neighbor(lightNode, direction);
+        Chunk* neighborChunk = getChunk(neighbor.chunkIndex);
+        if (!neighborChunk || !neighborChunk->composition().get(neighbor.blockIndex).hasTransparency())
+          continue;
+
+        // The raised channels are no brighter than the propagated light, so the neighbor never lands in a bucket that has already been processed
+        block::Light propagatedLight = light.propagated(direction);
+        if (!RaiseLight(*neighborChunk, neighbor.blockIndex, propagatedLight))
+          continue;
+
+        markAffected(neighbor);
+        m_Queues[propagatedLight.intensity()].push_back(neighbor);
+      }
+    }
+}
+
+const std::unordered_map<GlobalIndex, u64>& LightPropagator::affectedSections() const
+{
+  return m_AffectedSections;
+}
+
+
+
+void LightPropagator::removeLight()
+{
+  // Blocks bordering the darkened region may be lit by other sources, so they will be used to refill it
+  std::vector<LightNode> refillSources;
+  while (!m_RemovalQueue.empty())
+  {
+    RemovalNode removalNode = m_RemovalQueue.back();
+    m_RemovalQueue.pop_back();
+
+    for (eng::math::Direction direction : eng::math::Directions())
+    {
+      LightNode neighbor = Neighbor(removalNode.lightNode, direction);
+      Chunk* neighborChunk = getChunk(neighbor.chunkIndex);
+      if (!neighborChunk)
+        continue;
+
+      block::Light neighborLight = neighborChunk->lighting().get(neighbor.blockIndex);
+      if (neighborLight == block::Light())
+        continue;
+
+      // Light that came through the removed block is weaker than it, except for full sunlight traveling downward.
+      // Emissive blocks are never darkened below their own emission.
+      i8 emission = neighborChunk->composition().get(neighbor.blockIndex).lightEmission();
+      bool fullSunlightBelow = removalNode.removedLight.sunlight() == block::Light::MaxValue() && direction == eng::math::Direction::Bottom;
+      bool removeSunlight = neighborLight.sunlight() > 0 && (neighborLight.sunlight() < removalNode.removedLight.sunlight() ||
+                                                             (fullSunlightBelow && neighborLight.sunlight() == block::Light::MaxValue()));
+      bool removeBlockLight = neighborLight.blockLight() > emission && neighborLight.blockLight() < removalNode.removedLight.blockLight();
+      if (!removeSunlight && !removeBlockLight)
+      {
+        refillSources.push_back(neighbor);
+        continue;
+      }
+
+      block::Light darkenedLight(removeSunlight ? 0 : neighborLight.sunlight(), removeBlockLight ? emission : neighborLight.blockLight());
+      bool lightRemoved = neighborChunk->lighting().setIf(neighbor.blockIndex, darkenedLight, [neighborLight](block::Light blockLight)
+      {
+        return blockLight == neighborLight;
+      });
+      if (!lightRemoved)
+        continue;
+
+      markAffected(neighbor);
+      m_RemovalQueue.push_back({ neighbor, block::Light(removeSunlight ? neighborLight.sunlight() : 0, removeBlockLight ? neighborLight.blockLight() : 0) });
+      if (darkenedLight != block::Light())
+        refillSources.push_back(neighbor);
+    }
+  }
+
+  // Sources are added once removal is complete, since blocks may have been darkened after being found
+  for (const LightNode& refillSource : refillSources)
+    addSource(refillSource.chunkIndex, refillSource.blockIndex);
+}
+
+void LightPropagator::markAffected(const LightNode& lightNode)
+{
+  for (const LocalIndex& localIndex : ::affectedChunks(lightNode.blockIndex))
+  {
+    BlockIndex neighborBlockIndex = lightNode.blockIndex - Chunk::Size() * localIndex.checkedCast<blockIndex_t>();
+    m_AffectedSections[lightNode.chunkIndex + localIndex.upcast<globalIndex_t>()] |= ::affectedSections(neighborBlockIndex);
+  }
+}
+
+Chunk* LightPropagator::getChunk(const GlobalIndex& chunkIndex)
+{
+  auto [cachePosition, newEntry] = m_ChunkCache.try_emplace(chunkIndex);
+  if (newEntry)
+  {
+    std::shared_ptr<Chunk> chunk = m_Chunks.get(chunkIndex);
+    if (chunk && chunk->state() != Chunk::State::Generated)
+    {
+      chunk->beginLightingEdit();
+      cachePosition->second = std::move(chunk);
+    }
+  }
+  return cachePosition->second.get();
+}
+
+bool LightPropagator::RaiseLight(Chunk& chunk, const BlockIndex& blockIndex, block::Light light)
+{
+  // The write only succeeds if the value is unchanged since it was read, so concurrent propagations can only raise it further
+  block::Light currentLight = chunk.lighting().get(blockIndex);
+  while (true)
+  {
+    block::Light raisedLight = block::Light::Max(currentLight, light);
+    if (raisedLight == currentLight)
+      return false;
+
+    bool lightRaised = chunk.lighting().setIf(blockIndex, raisedLight, [currentLight](block::Light blockLight) { return blockLight == currentLight; });
+    if (lightRaised)
+      return true;
+    currentLight = chunk.lighting().get(blockIndex);
+  }
+}
+
+LightPropagator::LightNode LightPropagator::Neighbor(const LightNode& lightNode, eng::math::Direction direction)
+{
+  static constexpr blockIndex_t endOfChunk = Chunk::Size() - 1;
+
+  if (blockNeighborIsInAnotherChunk(lightNode.blockIndex, direction))
+    return { lightNode.chunkIndex + GlobalIndex::Dir(direction), lightNode.blockIndex - endOfChunk * BlockIndex::Dir(direction) };
+  return { lightNode.chunkIndex, lightNode.blockIndex + BlockIndex::Dir(direction) };
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+#include "Chunk.h"
+
+/*
+  Propagates light outward from a set of source blocks using a single breadth-first work queue that spans
+  chunk borders. Light crosses into neighboring chunks directly, so the cost of an update is proportional to
+  the number of blocks whose light changes rather than the number of chunks involved. Sunlight and block light
+  are carried together in each light value and propagated with a single pass.
+
+  Light can be removed with a two-phase approach: light that originated from a removed source is darkened first,
+  after which the surrounding blocks that are lit by other sources refill the darkened region. Chunks that have
+  not been lit for the first time are skipped, since they will be lit in full once their neighbors have loaded.
+  Every chunk the propagator touches is marked as being edited until the propagator is destroyed.
+*/
+class LightPropagator : private eng::NonCopyable
+{
+  struct LightNode
+  {
+    GlobalIndex chunkIndex;
+    BlockIndex blockIndex;
+  };
+
+  struct RemovalNode
+  {
+    LightNode lightNode;
+    block::Light removedLight;
+  };
+
+  static constexpr i8 c_Attenuation = 1;
+
+  const eng::thread::UnorderedMap<GlobalIndex, Chunk>& m_Chunks;
+  std::unordered_map<GlobalIndex, std::shared_ptr<Chunk>> m_ChunkCache;
+  std::array<std::vector<LightNode>, block::Light::MaxValue() + 1> m_Queues;
+  std::vector<RemovalNode> m_RemovalQueue;
+  std::unordered_map<GlobalIndex, u64> m_AffectedSections;
+
+public:
+  explicit LightPropagator(const eng::thread::UnorderedMap<GlobalIndex, Chunk>& chunks);
+  ~LightPropagator();
+
+  /*
+    Queues a block to spread its current light value to its neighbors.
+  */
+  void addSource(const GlobalIndex& chunkIndex, const BlockIndex& blockIndex);
+
+  /*
+    Queues the cardinal neighbors of a block as sources, including those that lie in neighboring chunks.
+  */
+  void addNeighborsAsSources(const GlobalIndex& chunkIndex, const BlockIndex& blockIndex);
+
+  /*
+    Raises the block light of a block to its light emission and queues it as a source.
+  */
+  void addEmitter(const GlobalIndex& chunkIndex, const BlockIndex& blockIndex);
+
+  /*
+    Queues a block to have its light removed, along with all light that was propagated through it.
+    Used when a block becomes opaque or stops emitting light. Light emitted by the block itself is kept.
+  */
+  void removeSource(const GlobalIndex& chunkIndex, const BlockIndex& blockIndex);
+
+  /*
+    Darkens all blocks lit by removed sources, then spreads light from queued sources and from
+    the blocks bordering the darkened region.
+  */
+  void propagate();
+
+  /*
+    \returns Sections whose meshes are affected by the light changes made during propagation, as a bit mask of
+             sections for each chunk. This includes sections that border a changed block, even if their own
+             lighting did not change.
+  */
+  const std::unordered_map<GlobalIndex, u64>& affectedSections() const;
+
+private:
+  void removeLight();
+  void markAffected(const LightNode& lightNode);
+
+  Chunk* getChunk(const GlobalIndex& chunkIndex);
+
+  /*
+    Raises each channel of a block's light to at least the given value.
+    \returns Whether the light of the block changed.
+  */
+  static bool RaiseLight(Chunk& chunk, const BlockIndex& blockIndex, block::Light light);
+  static LightNode Neighbor(const LightNode& lightNode, eng::math::Direction direction);
+};
\ No newline at end of file
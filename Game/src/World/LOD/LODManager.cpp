@@ -50,14 +50,26 @@ namespace lod
     length_t cellLength = node.length() / c_LODNumCells;
     eng::math::Vec2 lodAnchorXY = Chunk::Length() * static_cast<eng::math::Vec2>(node.anchor());
 
-    BlockArrayRect<SurfaceData> noiseValues(static_cast<BlockRect>(c_LODSampleBounds), eng::AllocationPolicy::ForOverwrite);
-    noiseValues.populate([cellLength, lodAnchorXY](BlockIndex2D index)
+    // Sample noise at cell corners
+    static constexpr i32 samplesPerRow = c_LODNumCells + 1;
+    auto samplePointIndex = [](BlockIndex2D index) { return samplesPerRow * index.i + index.j; };
+
+    BlockRect sampleBounds = static_cast<BlockRect>(c_LODSampleBounds);
+    std::vector<eng::math::Vec2> samplePoints(sampleBounds.volume());
+    for (const BlockIndex2D& index : sampleBounds)
+      samplePoints[samplePointIndex(index)] = lodAnchorXY + cellLength * static_cast<eng::math::Vec2>(index);
+
+    std::vector<biome::PropertyVector> terrainProperties(samplePoints.size());
+    std::vector<length_t> elevations(samplePoints.size());
+    terrain::terrainPropertiesAt(samplePoints, terrainProperties);
+    terrain::getApproximateElevation(samplePoints, terrainProperties, elevations);
+
+    BlockArrayRect<SurfaceData> noiseValues(sampleBounds, eng::AllocationPolicy::ForOverwrite);
+    noiseValues.populate([&samplePointIndex, &terrainProperties, &elevations](BlockIndex2D index)
     {
-      // Sample noise at cell corners
-      eng::math::Vec2 pointXY = lodAnchorXY + cellLength * static_cast<eng::math::Vec2>(index);
-      biome::PropertyVector terrainProperties = terrain::terrainPropertiesAt(pointXY);
-      biome::ID biome = terrain::biomeAt(terrainProperties);
-      return SurfaceData(terrain::getApproximateElevation(pointXY), terrain::getApproximateBlockType(biome));
+      i32 pointIndex = samplePointIndex(index);
+      biome::ID biome = terrain::biomeAt(terrainProperties[pointIndex]);
+      return SurfaceData(elevations[pointIndex], terrain::getApproximateBlockType(biome));
     });
     return noiseValues;
   }
@@ -1,12 +1,34 @@
 #include "GMpch.h"
 #include "Terrain.h"
+#include "TerrainPipeline.h"
 #include "TerrainProperties.h"
 #include "World/Chunk/Chunk.h"
 #include "World/Biome/BiomeTable.h"
+#include "Util/Noise.h"
 
 namespace terrain
 {
   static constexpr int c_TerrainMaxAmplitude = 100;
+
+  // Cave density is sampled on a coarse lattice and interpolated, and blocks are carved out where it exceeds the threshold
+  static constexpr blockIndex_t c_CaveLatticeStride = 8;
+  static constexpr blockIndex_t c_CaveLatticeCells = Chunk::Size() / c_CaveLatticeStride;
+  static constexpr blockIndex_t c_CaveLatticeNodes = c_CaveLatticeCells + 1;
+  static constexpr length_t c_CaveThreshold = 0.6_m;
+  static_assert(Chunk::Size() % c_CaveLatticeStride == 0, "Cave lattice cells must evenly divide a chunk!");
+
+  // Each chunk column is split into cells, each of which has a chance of containing a single tree
+  static constexpr blockIndex_t c_TreeCellSize = 8;
+  static constexpr blockIndex_t c_TreeCells = Chunk::Size() / c_TreeCellSize;
+  static constexpr u64 c_TreeChance = 4;  // One in c_TreeChance cells has a tree
+  static constexpr i32 c_MinTrunkHeight = 8;
+  static constexpr i32 c_TrunkHeightVariation = 4;
+  static constexpr i32 c_CanopyRadius = 3;
+  static constexpr i32 c_MaxTreeHeight = c_MinTrunkHeight + c_TrunkHeightVariation - 1 + c_CanopyRadius;  // Highest tree block above the surface block
+  static_assert(Chunk::Size() % c_TreeCellSize == 0, "Tree cells must evenly divide a chunk!");
+  static_assert(c_CanopyRadius < Chunk::Size(), "Trees can only reach into adjacent columns!");
+
+
   static constexpr eng::EnumArray<biome::PropertyVector, biome::ID> c_BiomeProperties =
     { { biome::ID::Default,  { { biome::Property::Elevation,  0.3_m } } },
       { biome::ID::Mountain, { { biome::Property::Elevation,  0.9_m } } },
@@ -28,6 +50,30 @@ namespace terrain
     return Chunk::Length() * static_cast<eng::math::Vec2>(chunkIndex) + block::length() * static_cast<eng::math::Vec2>(surfaceIndex) + block::length() / 2;
   }
 
+  static constexpr eng::math::Vec3 calculateBlockPosition(const GlobalIndex& chunkIndex, const BlockIndex& blockIndex)
+  {
+    return Chunk::Length() * static_cast<eng::math::Vec3>(chunkIndex) + block::length() * static_cast<eng::math::Vec3>(blockIndex) + block::length() / 2;
+  }
+
+  static constexpr i32 surfacePointIndex(BlockIndex2D surfaceIndex)
+  {
+    return Chunk::Size() * surfaceIndex.i + surfaceIndex.j;
+  }
+
+  /*
+    \returns The center of the first block column of a chunk column. The remaining block columns lie on a grid with
+              block-length spacing, ordered by surfacePointIndex.
+  */
+  static constexpr eng::math::Vec2 surfaceGridOrigin(const GlobalIndex2D& columnIndex)
+  {
+    return calculateBlockXY(GlobalIndex(columnIndex, 0), BlockIndex2D(0, 0));
+  }
+
+  static i32 surfaceBlock(length_t surfaceHeight)
+  {
+    return eng::arithmeticCastUnchecked<i32>(std::floor(surfaceHeight / block::length()));
+  }
+
   template<uSize N>
   static constexpr length_t evaluateShapingFunction(length_t x, const std::array<eng::math::Vec2, N>& controlPoints)
   {
@@ -42,7 +88,22 @@ namespace terrain
     return std::lerp(controlPointA->y, controlPointB->y, t);
   }
 
-  static length_t baseElevation(length_t elevationProperty, const eng::math::Vec2& pointXY)
+  static length_t elevationNoise(const eng::math::Vec2& pointXY)
+  {
+    return eng::math::normalizedOctaveNoise(pointXY, 6, 0.4f, 1000_m, 0.5f);
+  }
+
+  static void elevationNoise(std::span<const eng::math::Vec2> points, std::span<length_t> noiseValues)
+  {
+    eng::math::normalizedOctaveNoise(points, noiseValues, 6, 0.4f, 1000_m, 0.5f);
+  }
+
+  static void elevationNoise(const GlobalIndex2D& columnIndex, std::span<length_t> noiseValues)
+  {
+    eng::math::normalizedOctaveNoiseGrid(surfaceGridOrigin(columnIndex), block::length(), Chunk::Size(), noiseValues, 6, 0.4f, 1000_m, 0.5f);
+  }
+
+  static length_t baseElevation(length_t elevationProperty, length_t elevationNoise)
   {
     static constexpr std::array<eng::math::Vec2, 7> elevationControlPoints = { { { -0.55,  -0.1  },
                                                                                  { -0.525, -0.95 },
@@ -56,46 +117,65 @@ namespace terrain
 
     length_t elevationControl = evaluateShapingFunction(elevationProperty, elevationControlPoints);
     length_t variationControl = evaluateShapingFunction(elevationControl, variationControlPoints);
-    length_t noiseValue = eng::math::normalizedOctaveNoise(pointXY, 6, 0.4f, 1000_m, 0.5f) + 1;
+    length_t noiseValue = elevationNoise + 1;
     return c_TerrainMaxAmplitude * elevationControl + 0.2_m * c_TerrainMaxAmplitude * variationControl * noiseValue;
   }
 
-  static BlockArrayRect<biome::PropertyVector> terrainPropertyStage(const GlobalIndex& chunkIndex)
+  static void terrainPropertyStage(ColumnData& column)
   {
-    BlockArrayRect<biome::PropertyVector> properties(Chunk::Bounds2D(), eng::AllocationPolicy::ForOverwrite);
-    properties.populate([&chunkIndex](BlockIndex2D surfaceIndex) -> biome::PropertyVector
+    std::vector<length_t> elevationProperties(eng::math::square(Chunk::Size()));
+    terrain::elevationProperty(surfaceGridOrigin(column.columnIndex), block::length(), Chunk::Size(), elevationProperties);
+
+    column.terrainProperties = BlockArrayRect<biome::PropertyVector>(Chunk::Bounds2D(), eng::AllocationPolicy::ForOverwrite);
+    column.terrainProperties.populate([&elevationProperties](BlockIndex2D surfaceIndex) -> biome::PropertyVector
     {
-      return { { biome::Property::Elevation, terrain::elevationProperty(calculateBlockXY(chunkIndex, surfaceIndex)) } };
+      return { { biome::Property::Elevation, elevationProperties[surfacePointIndex(surfaceIndex)] } };
     });
-    return properties;
   }
 
-  static BlockArrayRect<length_t> heightMapStage(const BlockArrayRect<biome::PropertyVector>& terrainProperties, const GlobalIndex& chunkIndex)
+  static void heightMapStage(ColumnData& column)
   {
-    BlockArrayRect<length_t> heightMap(Chunk::Bounds2D(), eng::AllocationPolicy::ForOverwrite);
-    heightMap.populate([&terrainProperties, &chunkIndex](BlockIndex2D surfaceIndex)
+    std::vector<length_t> noiseValues(eng::math::square(Chunk::Size()));
+    elevationNoise(column.columnIndex, noiseValues);
+
+    column.heightMap = BlockArrayRect<length_t>(Chunk::Bounds2D(), eng::AllocationPolicy::ForOverwrite);
+    column.heightMap.populate([&column, &noiseValues](BlockIndex2D surfaceIndex)
     {
-      eng::math::Vec2 blockXY = calculateBlockXY(chunkIndex, surfaceIndex);
-      return baseElevation(elevationProperty(blockXY), blockXY);
+      return baseElevation(column.terrainProperties(surfaceIndex)[biome::Property::Elevation], noiseValues[surfacePointIndex(surfaceIndex)]);
     });
-    return heightMap;
+
+    auto [minSurfaceHeight, maxSurfaceHeight] = std::minmax_element(column.heightMap.begin(), column.heightMap.end());
+    column.minSurfaceBlock = surfaceBlock(*minSurfaceHeight);
+    column.maxSurfaceBlock = surfaceBlock(*maxSurfaceHeight);
   }
 
-  static BlockArrayBox<block::Type> fillStage(const BlockArrayRect<biome::PropertyVector>& terrainProperties, const BlockArrayRect<length_t>& heightMap, const GlobalIndex& chunkIndex)
+  static void fillStage(ChunkContext& context)
   {
+    const ColumnData& column = context.column();
+    const GlobalIndex& chunkIndex = context.chunkIndex();
+
+    // Chunks that lie entirely above or below the surface don't need to be filled column by column
+    i32 chunkFloor = eng::arithmeticCast<i32>(Chunk::Size() * chunkIndex.k);
+    if (column.maxSurfaceBlock < chunkFloor)
+      return;
+    if (column.minSurfaceBlock >= chunkFloor + Chunk::Size())
+    {
+      context.composition = BlockArrayBox<block::Type>(Chunk::Bounds(), block::Type(block::ID::Stone));
+      return;
+    }
+
     BlockArrayBox<block::Type> composition(Chunk::Bounds(), eng::AllocationPolicy::ForOverwrite);
 
     eng::algo::fill(composition, block::ID::Air);
-    heightMap.forEach([&composition, &terrainProperties, &chunkIndex](BlockIndex2D surfaceIndex, length_t surfaceHeight)
+    column.heightMap.forEach([&composition, &column, &chunkIndex](BlockIndex2D surfaceIndex, length_t surfaceHeight)
     {
-      i32 heightInBlocks = eng::arithmeticCastUnchecked<i32>(std::floor(surfaceHeight / block::length()));
-      i32 surfaceBlockInChunk = heightInBlocks - Chunk::Size() * chunkIndex.k;
+      i32 surfaceBlockInChunk = surfaceBlock(surfaceHeight) - Chunk::Size() * chunkIndex.k;
       if (surfaceBlockInChunk >= Chunk::Size())
         for (blockIndex_t k = 0; k < Chunk::Size(); ++k)
           composition[surfaceIndex.i][surfaceIndex.j][k] = block::ID::Stone;
       if (eng::withinBounds(surfaceBlockInChunk, 0, Chunk::Size()))
       {
-        biome::ID biome = biomeAt(terrainProperties(surfaceIndex));
+        biome::ID biome = biomeAt(column.terrainProperties(surfaceIndex));
         block::Type surfaceType = getApproximateBlockType(biome);
         block::Type soilType = surfaceType == block::ID::Grass ? block::ID::Dirt : surfaceType;
 
@@ -107,9 +187,157 @@ namespace terrain
           composition[surfaceIndex.i][surfaceIndex.j][k--] = block::ID::Stone;
       }
     });
-    return composition;
+    context.composition = std::move(composition);
+  }
+
+  static void caveStage(ChunkContext& context)
+  {
+    const ColumnData& column = context.column();
+    const GlobalIndex& chunkIndex = context.chunkIndex();
+
+    // Caves are only carved out of terrain, so anything above the surface can be skipped
+    i32 chunkFloor = eng::arithmeticCast<i32>(Chunk::Size() * chunkIndex.k);
+    if (column.maxSurfaceBlock < chunkFloor)
+      return;
+
+    std::array<std::array<i32, c_CaveLatticeCells>, c_CaveLatticeCells> cellSurfaceBlocks;
+    for (std::array<i32, c_CaveLatticeCells>& cellRow : cellSurfaceBlocks)
+      cellRow.fill(std::numeric_limits<i32>::lowest());
+    column.heightMap.forEach([&cellSurfaceBlocks, chunkFloor](BlockIndex2D surfaceIndex, length_t surfaceHeight)
+    {
+      i32& cellSurfaceBlock = cellSurfaceBlocks[surfaceIndex.i / c_CaveLatticeStride][surfaceIndex.j / c_CaveLatticeStride];
+      cellSurfaceBlock = std::max(cellSurfaceBlock, surfaceBlock(surfaceHeight) - chunkFloor);
+    });
+
+    // Lattice nodes are sampled the first time a cell that reaches below the surface needs them
+    std::array<std::optional<length_t>, eng::math::cube(c_CaveLatticeNodes)> densities;
+    auto density = [&densities, &chunkIndex](const BlockIndex& nodeIndex)
+    {
+      std::optional<length_t>& nodeDensity = densities[eng::math::square(c_CaveLatticeNodes) * nodeIndex.i + c_CaveLatticeNodes * nodeIndex.j + nodeIndex.k];
+      if (!nodeDensity)
+        nodeDensity = noise::fastTerrainNoise3D(calculateBlockPosition(chunkIndex, c_CaveLatticeStride * nodeIndex));
+      return *nodeDensity;
+    };
+
+    for (const BlockIndex& cellIndex : BlockBox(0, c_CaveLatticeCells - 1))
+    {
+      if (c_CaveLatticeStride * cellIndex.k > cellSurfaceBlocks[cellIndex.i][cellIndex.j])
+        continue;
+
+      // Trilinear interpolation never exceeds the largest corner value, so cells whose corners are all below the threshold stay solid
+      std::array<length_t, 8> cornerDensities;
+      for (const BlockIndex& corner : BlockBox(0, 1))
+        cornerDensities[4 * corner.i + 2 * corner.j + corner.k] = density(cellIndex + corner);
+      if (eng::algo::noneOf(cornerDensities, [](length_t cornerDensity) { return cornerDensity > c_CaveThreshold; }))
+        continue;
+
+      // Interpolate the bottom and top faces of the cell bilinearly, then interpolate linearly between them
+      BlockIndex cellAnchor = c_CaveLatticeStride * cellIndex;
+      for (const BlockIndex2D& offset : BlockRect(0, c_CaveLatticeStride - 1))
+      {
+        length_t u = eng::arithmeticUpcast<length_t>(offset.i) / c_CaveLatticeStride;
+        length_t v = eng::arithmeticUpcast<length_t>(offset.j) / c_CaveLatticeStride;
+        auto faceDensity = [&cornerDensities, u, v](i32 k)
+        {
+          return std::lerp(std::lerp(cornerDensities[k], cornerDensities[4 + k], u), std::lerp(cornerDensities[2 + k], cornerDensities[6 + k], u), v);
+        };
+        length_t bottomDensity = faceDensity(0);
+        length_t topDensity = faceDensity(1);
+        if (std::max(bottomDensity, topDensity) <= c_CaveThreshold)
+          continue;
+
+        for (blockIndex_t k = 0; k < c_CaveLatticeStride; ++k)
+          if (std::lerp(bottomDensity, topDensity, eng::arithmeticUpcast<length_t>(k) / c_CaveLatticeStride) > c_CaveThreshold)
+            context.composition(cellAnchor + BlockIndex(offset.i, offset.j, k)) = block::ID::Air;
+      }
+    }
   }
 
+  /*
+    \returns A hash of the given cell that is stable across runs, used to seed the features in that cell.
+  */
+  static u64 featureHash(const GlobalIndex2D& columnIndex, const BlockIndex2D& cellIndex)
+  {
+    u64 hash = 0x9E3779B97F4A7C15 * std::bit_cast<u32>(columnIndex.i) + 0xC2B2AE3D27D4EB4F * std::bit_cast<u32>(columnIndex.j) +
+               0x165667B19E3779F9 * eng::arithmeticCast<u64>(c_TreeCells * cellIndex.i + cellIndex.j);
+
+    // SplitMix64 finalizer, so that neighboring cells are uncorrelated
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EB;
+    return hash ^ (hash >> 31);
+  }
+
+  static void treePlacementStage(ColumnData& column)
+  {
+    for (const BlockIndex2D& cellIndex : BlockRect(0, c_TreeCells - 1))
+    {
+      u64 hash = featureHash(column.columnIndex, cellIndex);
+      if (hash % c_TreeChance != 0)
+        continue;
+
+      // Trees are kept off the edges of their cell so that trunks never touch
+      BlockIndex2D offsetInCell(eng::arithmeticCastUnchecked<blockIndex_t>(1 + (hash >> 8) % (c_TreeCellSize - 2)),
+                                eng::arithmeticCastUnchecked<blockIndex_t>(1 + (hash >> 16) % (c_TreeCellSize - 2)));
+      BlockIndex2D surfaceIndex = c_TreeCellSize * cellIndex + offsetInCell;
+      if (biomeAt(column.terrainProperties(surfaceIndex)) != biome::ID::Default)
+        continue;
+
+      i32 rootBlock = surfaceBlock(column.heightMap(surfaceIndex)) + 1;
+      i32 trunkHeight = c_MinTrunkHeight + eng::arithmeticCastUnchecked<i32>((hash >> 24) % c_TrunkHeightVariation);
+      column.trees.push_back({ surfaceIndex, rootBlock, trunkHeight });
+    }
+  }
+
+  /*
+    Places the parts of the trees in the chunk's column and the columns around it that lie within the chunk.
+    Trees are regenerated from their column data by every chunk they reach into, so neighboring chunks never need to wait for one another.
+  */
+  static void treeStage(ChunkContext& context)
+  {
+    eng::math::IBox3<i32> chunkBounds = Chunk::Bounds().upcast<i32>();
+    i32 chunkFloor = eng::arithmeticCast<i32>(Chunk::Size() * context.chunkIndex().k);
+
+    for (const GlobalIndex2D& columnOffset : GlobalRect(-1, 1))
+      for (const TreeSite& tree : context.column(columnOffset).trees)
+      {
+        // Positions are relative to the chunk being generated
+        eng::math::IVec3<i32> root(Chunk::Size() * columnOffset.i + tree.surfaceIndex.i, Chunk::Size() * columnOffset.j + tree.surfaceIndex.j, tree.rootBlock - chunkFloor);
+        eng::math::IVec3<i32> canopyCenter = root + eng::math::IVec3<i32>(0, 0, tree.trunkHeight - 1);
+
+        eng::math::IBox3<i32> treeBounds(root - eng::math::IVec3<i32>(c_CanopyRadius, c_CanopyRadius, 0), canopyCenter + c_CanopyRadius);
+        if (!treeBounds.overlapsWith(chunkBounds))
+          continue;
+
+        if (!context.composition)
+          context.composition = BlockArrayBox<block::Type>(Chunk::Bounds(), block::Type(block::ID::Air));
+
+        for (const eng::math::IVec3<i32>& position : eng::math::IBox3<i32>::Intersection(treeBounds, chunkBounds))
+        {
+          block::Type& blockType = context.composition(position.checkedCast<blockIndex_t>());
+
+          eng::math::IVec3<i32> trunkOffset = position - root;
+          if (trunkOffset.i == 0 && trunkOffset.j == 0 && trunkOffset.k < tree.trunkHeight)
+          {
+            if (blockType == block::ID::Air || blockType == block::ID::OakLeaves)
+              blockType = block::ID::OakLog;
+            continue;
+          }
+
+          eng::math::IVec3<i32> canopyOffset = position - canopyCenter;
+          if (canopyOffset.dot(canopyOffset) <= eng::math::square(c_CanopyRadius) && blockType == block::ID::Air)
+            blockType = block::ID::OakLeaves;
+        }
+      }
+  }
+
+  static Pipeline s_Pipeline({ Stage("Terrain properties", {}, { StageData::TerrainProperties }, terrainPropertyStage),
+                               Stage("Height map", { StageData::TerrainProperties }, { StageData::HeightMap }, heightMapStage),
+                               Stage("Tree placement", { StageData::TerrainProperties, StageData::HeightMap }, { StageData::Trees }, treePlacementStage),
+                               Stage("Fill", Footprint::Chunk, { StageData::TerrainProperties, StageData::HeightMap }, { StageData::Composition }, fillStage),
+                               Stage("Caves", Footprint::Chunk, { StageData::HeightMap, StageData::Composition }, { StageData::Composition }, caveStage),
+                               Stage("Trees", Footprint::ChunkWithHalo, { StageData::Trees, StageData::Composition }, { StageData::Composition }, treeStage) },
+                             eng::math::square(2 * param::UnloadDistance() + 3));
+
   biome::PropertyVector terrainPropertiesAt(const eng::math::Vec2& pointXY)
   {
     return { { biome::Property::Elevation, terrain::elevationProperty(pointXY) } };
@@ -134,17 +362,82 @@ namespace terrain
   length_t getApproximateElevation(const eng::math::Vec2& pointXY)
   {
     biome::PropertyVector terrainProperties = terrainPropertiesAt(pointXY);
-    return baseElevation(terrainProperties[biome::Property::Elevation], pointXY);
+    return baseElevation(terrainProperties[biome::Property::Elevation], elevationNoise(pointXY));
+  }
+
+  void terrainPropertiesAt(std::span<const eng::math::Vec2> points, std::span<biome::PropertyVector> terrainProperties)
+  {
+    std::vector<length_t> elevationProperties(points.size());
+    terrain::elevationProperty(points, elevationProperties);
+    for (uSize pointIndex = 0; pointIndex < points.size(); ++pointIndex)
+      terrainProperties[pointIndex] = { { biome::Property::Elevation, elevationProperties[pointIndex] } };
+  }
+
+  void getApproximateElevation(std::span<const eng::math::Vec2> points, std::span<const biome::PropertyVector> terrainProperties, std::span<length_t> elevations)
+  {
+    elevationNoise(points, elevations);
+    for (uSize pointIndex = 0; pointIndex < points.size(); ++pointIndex)
+      elevations[pointIndex] = baseElevation(terrainProperties[pointIndex][biome::Property::Elevation], elevations[pointIndex]);
+  }
+
+  bool isKnownEmpty(const GlobalIndex& chunkIndex)
+  {
+    // Trees can reach above the surface of their own column and into the columns around it
+    i32 chunkFloor = eng::arithmeticCast<i32>(Chunk::Size() * chunkIndex.k);
+    GlobalIndex2D columnIndex(chunkIndex.i, chunkIndex.j);
+    return eng::algo::noneOf(GlobalRect(-1, 1), [&columnIndex, chunkFloor](const GlobalIndex2D& columnOffset)
+    {
+      return s_Pipeline.columnData(columnIndex + columnOffset)->maxSurfaceBlock + c_MaxTreeHeight >= chunkFloor;
+    });
   }
 
   BlockArrayBox<block::Type> generateNew(const GlobalIndex& chunkIndex)
   {
-    BlockArrayRect<biome::PropertyVector> terrainProperties = terrainPropertyStage(chunkIndex);
-    BlockArrayRect<length_t> heightMap = heightMapStage(terrainProperties, chunkIndex);
-    BlockArrayBox<block::Type> composition = fillStage(terrainProperties, heightMap, chunkIndex);
+    return s_Pipeline.generate(chunkIndex);
+  }
+  void benchmarkNoise(const GlobalIndex2D& columnIndex)
+  {
+    static constexpr i32 c_Iterations = 100;
+    static constexpr length_t c_MaxGridError = 0.005_m;  // Each interpolated octave is within 0.5% of its amplitude, and normalized amplitudes sum to 1
+
+    std::vector<eng::math::Vec2> points(eng::math::square(Chunk::Size()));
+    for (const BlockIndex2D& surfaceIndex : Chunk::Bounds2D())
+      points[surfacePointIndex(surfaceIndex)] = calculateBlockXY(GlobalIndex(columnIndex, 0), surfaceIndex);
 
-    if (composition.filledWith(block::ID::Air))
-      composition.clear();
-    return composition;
+    // Evaluates the noise at every point of the column exactly and on the grid, and compares the results
+    auto compare = [&points](std::string_view name, auto&& exactNoise, auto&& gridNoise)
+    {
+      std::vector<length_t> exactValues(points.size());
+      std::vector<length_t> gridValues(points.size());
+      {
+        eng::debug::Timer timer(std::string(name) + " (exact)");
+        timer.timeStart();
+        for (i32 iteration = 0; iteration < c_Iterations; ++iteration)
+          for (uSize pointIndex = 0; pointIndex < points.size(); ++pointIndex)
+            exactValues[pointIndex] = exactNoise(points[pointIndex]);
+        timer.timeStop();
+      }
+      {
+        eng::debug::Timer timer(std::string(name) + " (grid)");
+        timer.timeStart();
+        for (i32 iteration = 0; iteration < c_Iterations; ++iteration)
+          gridNoise(gridValues);
+        timer.timeStop();
+      }
+
+      length_t maxError = 0;
+      for (uSize pointIndex = 0; pointIndex < points.size(); ++pointIndex)
+        maxError = std::max(maxError, std::abs(gridValues[pointIndex] - exactValues[pointIndex]));
+      ENG_INFO("{0}: max grid error {1} ({2})", name, maxError, maxError <= c_MaxGridError ? "within bound" : "exceeds bound");
+    };
+
+    compare("Elevation property", [](const eng::math::Vec2& pointXY) { return elevationProperty(pointXY); }, [&columnIndex](std::span<length_t> values)
+    {
+      elevationProperty(surfaceGridOrigin(columnIndex), block::length(), Chunk::Size(), values);
+    });
+    compare("Elevation noise", [](const eng::math::Vec2& pointXY) { return elevationNoise(pointXY); }, [&columnIndex](std::span<length_t> values)
+    {
+      elevationNoise(columnIndex, values);
+    });
   }
 }
\ No newline at end of file
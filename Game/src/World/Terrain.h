@@ -11,5 +11,23 @@ namespace terrain
   block::Type getApproximateBlockType(biome::ID biome);
   length_t getApproximateElevation(const eng::math::Vec2& pointXY);
 
+  /*
+    Batch versions of the functions above, which evaluate the terrain noise for many points at once.
+    Elevations are computed from terrain properties that have already been evaluated at the same points.
+  */
+  void terrainPropertiesAt(std::span<const eng::math::Vec2> points, std::span<biome::PropertyVector> terrainProperties);
+  void getApproximateElevation(std::span<const eng::math::Vec2> points, std::span<const biome::PropertyVector> terrainProperties, std::span<length_t> elevations);
+
+  /*
+    \returns True if the chunk lies entirely above the terrain surface, and so would be generated as air.
+  */
+  bool isKnownEmpty(const GlobalIndex& chunkIndex);
+
   BlockArrayBox<block::Type> generateNew(const GlobalIndex& chunkIndex);
+
+  /*
+    Times the grid evaluation of the terrain noise against exact per-point evaluation on the given chunk column and
+    logs the results. Also checks that the grid values stay within the error bound of the interpolated octaves.
+  */
+  void benchmarkNoise(const GlobalIndex2D& columnIndex);
 }
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "GMpch.h"
+#include "TerrainPipeline.h"
+#include "World/Chunk/Chunk.h"
+
+namespace terrain
+{
+  ColumnData::ColumnData(const GlobalIndex2D& index)
+    : columnIndex(index),
+      terrainProperties(Chunk::Bounds2D(), eng::AllocationPolicy::Deferred),
+      heightMap(Chunk::Bounds2D(), eng::AllocationPolicy::Deferred),
+      minSurfaceBlock(0),
+      maxSurfaceBlock(0) {}
+
+  ChunkContext::ChunkContext(const GlobalIndex& chunkIndex, const std::array<std::shared_ptr<const ColumnData>, 9>& columns)
+    : m_ChunkIndex(chunkIndex),
+      m_Columns(columns),
+      composition(Chunk::Bounds(), eng::AllocationPolicy::Deferred) {}
+
+  const GlobalIndex& ChunkContext::chunkIndex() const { return m_ChunkIndex; }
+  const ColumnData& ChunkContext::column() const { return column(GlobalIndex2D(0, 0)); }
+
+  const ColumnData& ChunkContext::column(const GlobalIndex2D& offset) const
+  {
+    const std::shared_ptr<const ColumnData>& columnData = m_Columns[ColumnSlot(offset)];
+    ENG_ASSERT(columnData, "Column data is only available to halo stages!");
+    return *columnData;
+  }
+
+  i32 ChunkContext::ColumnSlot(const GlobalIndex2D& offset)
+  {
+    ENG_ASSERT(eng::withinBounds(offset.i, -1, 2) && eng::withinBounds(offset.j, -1, 2), "Column offset is outside of the halo!");
+    return 3 * (offset.i + 1) + (offset.j + 1);
+  }
+
+  Stage::Stage(std::string_view stageName, eng::EnumBitMask<StageData> stageInputs, eng::EnumBitMask<StageData> stageOutputs, ColumnFunction function)
+    : name(stageName),
+      footprint(Footprint::Column),
+      inputs(stageInputs),
+      outputs(stageOutputs),
+      columnFunction(std::move(function)) {}
+
+  Stage::Stage(std::string_view stageName, Footprint stageFootprint, eng::EnumBitMask<StageData> stageInputs, eng::EnumBitMask<StageData> stageOutputs, ChunkFunction function)
+    : name(stageName),
+      footprint(stageFootprint),
+      inputs(stageInputs),
+      outputs(stageOutputs),
+      chunkFunction(std::move(function)) {}
+
+  Pipeline::Pipeline(const std::vector<Stage>& stages, i32 columnCacheSize)
+    : m_HasHaloStages(false),
+      m_ColumnCache(columnCacheSize)
+  {
+    // Column stages run before any chunk stage, so they can only depend on the outputs of other column stages
+    eng::EnumBitMask<StageData> columnOutputs;
+    eng::EnumBitMask<StageData> availableData;
+    for (const Stage& stage : stages)
+    {
+      eng::EnumBitMask<StageData> stageDependencies = stage.footprint == Footprint::Column ? columnOutputs : availableData;
+      for (StageData data : eng::EnumIterator<StageData>())
+        if (stage.inputs[data] && !stageDependencies[data])
+          throw eng::Exception("Terrain stage reads data that is not produced by an earlier stage!");
+
+      for (StageData data : eng::EnumIterator<StageData>())
+        if (stage.outputs[data])
+        {
+          availableData.set(data);
+          if (stage.footprint == Footprint::Column)
+            columnOutputs.set(data);
+        }
+
+      if (stage.footprint == Footprint::Column)
+        m_ColumnStages.push_back(stage);
+      else
+        m_ChunkStages.push_back(stage);
+      m_HasHaloStages |= stage.footprint == Footprint::ChunkWithHalo;
+    }
+  }
+
+  std::shared_ptr<const ColumnData> Pipeline::columnData(const GlobalIndex2D& columnIndex)
+  {
+    if (std::shared_ptr<const ColumnData> cachedData = m_ColumnCache.get(columnIndex))
+      return cachedData;
+
+    // Chunks of the same column are often generated at the same time. Only the first of them generates the column, the rest wait for it.
+    std::promise<std::shared_ptr<const ColumnData>> columnPromise;
+    std::shared_future<std::shared_ptr<const ColumnData>> pendingColumn;
+    {
+      std::lock_guard lock(m_PendingColumnsMutex);
+
+      // The column may have been finished since the cache was checked
+      if (std::shared_ptr<const ColumnData> cachedData = m_ColumnCache.get(columnIndex))
+        return cachedData;
+
+      auto [pendingPosition, insertionSuccess] = m_PendingColumns.try_emplace(columnIndex, columnPromise.get_future().share());
+      if (!insertionSuccess)
+        pendingColumn = pendingPosition->second;
+    }
+    if (pendingColumn.valid())
+      return pendingColumn.get();
+
+    std::shared_ptr<ColumnData> columnData;
+    try
+    {
+      columnData = generateColumn(columnIndex);
+    }
+    catch (...)
+    {
+      // Waiting chunks receive the exception, and later requests retry the column instead of finding a broken promise
+      {
+        std::lock_guard lock(m_PendingColumnsMutex);
+        m_PendingColumns.erase(columnIndex);
+      }
+      columnPromise.set_exception(std::current_exception());
+      throw;
+    }
+
+    {
+      std::lock_guard lock(m_PendingColumnsMutex);
+      m_ColumnCache.insert(columnIndex, columnData);
+      m_PendingColumns.erase(columnIndex);
+    }
+    columnPromise.set_value(columnData);
+    return columnData;
+  }
+
+  BlockArrayBox<block::Type> Pipeline::generate(const GlobalIndex& chunkIndex)
+  {
+    ENG_PROFILE_FUNCTION();
+
+    GlobalIndex2D columnIndex(chunkIndex.i, chunkIndex.j);
+    std::array<std::shared_ptr<const ColumnData>, 9> columns{};
+    columns[ChunkContext::ColumnSlot(GlobalIndex2D(0, 0))] = columnData(columnIndex);
+    if (m_HasHaloStages)
+      for (const GlobalIndex2D& columnOffset : GlobalRect(-1, 1))
+        columns[ChunkContext::ColumnSlot(columnOffset)] = columnData(columnIndex + columnOffset);
+
+    ChunkContext context(chunkIndex, columns);
+    for (const Stage& stage : m_ChunkStages)
+    {
+      ENG_PROFILE_SCOPE(stage.name);
+      stage.chunkFunction(context);
+    }
+    return std::move(context.composition);
+  }
+
+  std::shared_ptr<ColumnData> Pipeline::generateColumn(const GlobalIndex2D& columnIndex) const
+  {
+    std::shared_ptr<ColumnData> columnData = std::make_shared<ColumnData>(columnIndex);
+    for (const Stage& stage : m_ColumnStages)
+    {
+      ENG_PROFILE_SCOPE(stage.name);
+      stage.columnFunction(*columnData);
+    }
+    return columnData;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+#include "Indexing/Definitions.h"
+#include "Block/Block.h"
+#include "World/Biome/BiomeHelpers.h"
+
+namespace terrain
+{
+  /*
+    Pieces of data produced during terrain generation. Stages declare which of these they read and write, so that the
+    pipeline can check that every stage runs after the stages it depends on.
+  */
+  enum class StageData
+  {
+    TerrainProperties,
+    HeightMap,
+    Trees,
+    Composition,
+
+    First = 0, Last = Composition
+  };
+
+  /*
+    The region of the world a stage operates on.
+      Column:         Runs once per chunk column. Its outputs are cached and shared by every chunk in the column.
+      Chunk:          Runs once per chunk, with access to the data of the chunk's column.
+      ChunkWithHalo:  Runs once per chunk, with access to the data of the chunk's column and the eight columns around it.
+  */
+  enum class Footprint
+  {
+    Column,
+    Chunk,
+    ChunkWithHalo,
+
+    First = 0, Last = ChunkWithHalo
+  };
+
+  /*
+    A tree rooted in a chunk column. The root is the lowest block of the trunk, in blocks above the bottom of chunk layer zero.
+  */
+  struct TreeSite
+  {
+    BlockIndex2D surfaceIndex;
+    i32 rootBlock;
+    i32 trunkHeight;
+  };
+
+  /*
+    Terrain data that only depends on the horizontal position of a chunk. It is written by column stages.
+  */
+  struct ColumnData
+  {
+    GlobalIndex2D columnIndex;
+    BlockArrayRect<biome::PropertyVector> terrainProperties;
+    BlockArrayRect<length_t> heightMap;
+    i32 minSurfaceBlock;  // Lowest and highest surface heights of the column, in blocks
+    i32 maxSurfaceBlock;
+    std::vector<TreeSite> trees;
+
+    ColumnData(const GlobalIndex2D& index);
+  };
+
+  /*
+    The data available to the chunk stages of a single chunk. Chunk stages read column data and build up the composition,
+    which starts out as all air.
+  */
+  class ChunkContext
+  {
+    GlobalIndex m_ChunkIndex;
+    std::array<std::shared_ptr<const ColumnData>, 9> m_Columns;
+
+  public:
+    BlockArrayBox<block::Type> composition;
+
+    ChunkContext(const GlobalIndex& chunkIndex, const std::array<std::shared_ptr<const ColumnData>, 9>& columns);
+
+    const GlobalIndex& chunkIndex() const;
+    const ColumnData& column() const;
+
+    /*
+      \returns The data of the column at the given horizontal offset from the chunk's column. Only available to halo stages.
+    */
+    const ColumnData& column(const GlobalIndex2D& offset) const;
+
+    static i32 ColumnSlot(const GlobalIndex2D& offset);
+  };
+
+  struct Stage
+  {
+    using ColumnFunction = std::function<void(ColumnData&)>;
+    using ChunkFunction = std::function<void(ChunkContext&)>;
+
+    std::string_view name;
+    Footprint footprint;
+    eng::EnumBitMask<StageData> inputs;
+    eng::EnumBitMask<StageData> outputs;
+    ColumnFunction columnFunction;
+    ChunkFunction chunkFunction;
+
+    Stage(std::string_view stageName, eng::EnumBitMask<StageData> stageInputs, eng::EnumBitMask<StageData> stageOutputs, ColumnFunction function);
+    Stage(std::string_view stageName, Footprint stageFootprint, eng::EnumBitMask<StageData> stageInputs, eng::EnumBitMask<StageData> stageOutputs, ChunkFunction function);
+  };
+
+  /*
+    Runs an ordered list of terrain generation stages. Column stages run at most once per column, even when several
+    chunks of the same column are generated in parallel, and their outputs are kept in a cache of recently used columns.
+    Chunk stages then run in order for every generated chunk.
+  */
+  class Pipeline : private eng::NonCopyable
+  {
+    std::vector<Stage> m_ColumnStages;
+    std::vector<Stage> m_ChunkStages;
+    bool m_HasHaloStages;
+
+    eng::thread::LRUCache<GlobalIndex2D, ColumnData> m_ColumnCache;
+    std::mutex m_PendingColumnsMutex;
+    std::unordered_map<GlobalIndex2D, std::shared_future<std::shared_ptr<const ColumnData>>> m_PendingColumns;
+
+  public:
+    /*
+      Stages run in the given order. Throws if a stage reads data that no earlier stage produces.
+    */
+    Pipeline(const std::vector<Stage>& stages, i32 columnCacheSize);
+
+    std::shared_ptr<const ColumnData> columnData(const GlobalIndex2D& columnIndex);
+    BlockArrayBox<block::Type> generate(const GlobalIndex& chunkIndex);
+
+  private:
+    std::shared_ptr<ColumnData> generateColumn(const GlobalIndex2D& columnIndex) const;
+  };
+}
\ No newline at end of file
@@ -7,4 +7,14 @@ namespace terrain
   {
     return eng::math::normalizedOctaveNoise(pointXY, 6, 0.3f, 10000_m, 0.5f);
   }
+
+  void elevationProperty(std::span<const eng::math::Vec2> points, std::span<length_t> elevationProperties)
+  {
+    eng::math::normalizedOctaveNoise(points, elevationProperties, 6, 0.3f, 10000_m, 0.5f);
+  }
+
+  void elevationProperty(const eng::math::Vec2& origin, length_t spacing, i32 gridSize, std::span<length_t> elevationProperties)
+  {
+    eng::math::normalizedOctaveNoiseGrid(origin, spacing, gridSize, elevationProperties, 6, 0.3f, 10000_m, 0.5f);
+  }
 }
\ No newline at end of file
@@ -4,4 +4,10 @@
 namespace terrain
 {
   length_t elevationProperty(const eng::math::Vec2& pointXY);
+  void elevationProperty(std::span<const eng::math::Vec2> points, std::span<length_t> elevationProperties);
+
+  /*
+    Evaluates the elevation property over a square grid of points, as laid out by eng::math::octaveNoiseGrid.
+  */
+  void elevationProperty(const eng::math::Vec2& origin, length_t spacing, i32 gridSize, std::span<length_t> elevationProperties);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "GMpch.h"
 #include "World.h"
 #include "Player/Player.h"
+#include "World/Terrain.h"
 
 static constexpr length_t c_MinDistanceToWall = 0.01_m * block::length();
 
@@ -230,5 +231,13 @@ bool World::onKeyPress(eng::event::KeyPress& event)
   if (event.keyCode() == eng::input::Key::F3)
     m_RenderingPaused = !m_RenderingPaused;
 
+  // Benchmarks block the main thread while they run, so they are left out of distribution builds
+#if !defined(ENG_DIST)
+  if (event.keyCode() == eng::input::Key::F5)
+    m_ChunkManager.benchmarkFaceLighting();
+  if (event.keyCode() == eng::input::Key::F6)
+    terrain::benchmarkNoise(GlobalIndex2D(player::originIndex().i, player::originIndex().j));
+#endif
+
   return false;
 }
\ No newline at end of file